@@ -69,6 +69,10 @@ export const MspFn = {
 
 	// 0x417_ Task Manager
 	TASK_STATUS: 0x4170,
+	TASK_LATENCY: 0x4171,
+	TRACE_START: 0x4172,
+	GET_TRACE: 0x4173,
+	BENCHMARK: 0x4174,
 
 	// 0x418_ Receiver
 	GET_RX_STATUS: 0x4180,
@@ -70,6 +70,7 @@ export type LogFrame = {
 		};
 	};
 	frametime?: number;
+	gyroLatency?: number;
 	attitude: {
 		roll?: number;
 		pitch?: number;
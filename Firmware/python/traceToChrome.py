@@ -0,0 +1,110 @@
+"""Convert a Kolibri task trace (.ktrc) to Chrome trace_event JSON.
+
+The .ktrc file is written by the configurator (tasks page, "Record trace") or by the SITL build (-T).
+Open the output in chrome://tracing or https://ui.perfetto.dev.
+
+Usage: python traceToChrome.py trace.ktrc [trace.json]
+
+File format (little endian):
+    "KTRC", u8 version (1), u8 core count, u16 reserved, u32 F_CPU
+    per core: u32 sync cycles, u32 sync us, u32 event count, then the events
+    event: u32 start cycles, u32 duration cycles (lower 24 bits) | task id << 24
+"""
+import json
+import struct
+import sys
+from pathlib import Path
+
+# same order as enum Tasks in src/taskManager.h
+TASK_NAMES = [
+    "Loop 0",
+    "Speaker",
+    "Baro Eval",
+    "Blackbox",
+    "ELRS",
+    "Modes",
+    "ADC",
+    "Serial",
+    "Configurator",
+    "GPS",
+    "Magnetometer",
+    "Task Manager",
+    "Dynamic Notch",
+    "Loop 1",
+    "Gyro Read",
+    "IMU",
+    "IMU Gyro",
+    "IMU Accel",
+    "IMU Angle",
+    "PID, Motors",
+    "ESC RPM",
+    "OSD",
+    "Baro Read",
+    "Gyro to Motor Latency",
+]
+
+
+def task_name(task_id):
+    return TASK_NAMES[task_id] if task_id < len(TASK_NAMES) else f"Task {task_id}"
+
+
+def read_trace(data):
+    magic, version, cores, _, f_cpu = struct.unpack_from("<4sBBHI", data, 0)
+    if magic != b"KTRC" or version != 1:
+        raise ValueError("not a version 1 .ktrc file")
+    cycles_per_us = f_cpu / 1e6
+    offset = 12
+    events = []
+    for core in range(cores):
+        sync_cycles, sync_us, count = struct.unpack_from("<III", data, offset)
+        offset += 12
+        for i in range(count):
+            start, duration_id = struct.unpack_from("<II", data, offset + i * 8)
+            # the cycle counter wraps every 16 s, the events of one capture are much closer to the sync point
+            delta = (start - sync_cycles + 0x80000000) % 0x100000000 - 0x80000000
+            events.append(
+                {
+                    "core": core,
+                    "task": duration_id >> 24,
+                    "ts": sync_us + delta / cycles_per_us,
+                    "dur": (duration_id & 0xFFFFFF) / cycles_per_us,
+                    "saturated": (duration_id & 0xFFFFFF) == 0xFFFFFF,
+                }
+            )
+        offset += count * 8
+    return events
+
+
+def to_chrome(events):
+    trace = []
+    t0 = min((e["ts"] for e in events), default=0)
+    for core in sorted({e["core"] for e in events}):
+        trace.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core, "args": {"name": f"Core {core}"}})
+    for e in events:
+        entry = {
+            "name": task_name(e["task"]),
+            "ph": "X",
+            "pid": 0,
+            "tid": e["core"],
+            "ts": round(e["ts"] - t0, 3),
+            "dur": round(e["dur"], 3),
+        }
+        if e["saturated"]:
+            entry["args"] = {"note": "duration saturated at 2^24 cycles"}
+        trace.append(entry)
+    return {"traceEvents": trace, "displayTimeUnit": "ns"}
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(2)
+    src = Path(sys.argv[1])
+    dst = Path(sys.argv[2]) if len(sys.argv) > 2 else src.with_suffix(".json")
+    events = read_trace(src.read_bytes())
+    dst.write_text(json.dumps(to_chrome(events)))
+    print(f"{len(events)} events written to {dst}")
+
+
+if __name__ == "__main__":
+    main()
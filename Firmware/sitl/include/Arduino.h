@@ -0,0 +1,146 @@
+#pragma once
+// Host replacement for the Arduino-Pico core, only covers what the flight-control core uses
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "sitl.h"
+
+#define PI 3.1415926535897932384626433832795
+#define HALF_PI 1.5707963267948966192313216916398
+#define TWO_PI 6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define PROGMEM
+#define __not_in_flash(group)
+#define __not_in_flash_func(name) name
+#define __no_inline_not_in_flash_func(name) name
+#define __uninitialized_ram(name) name
+#define __scratch_x(name)
+#define __scratch_y(name)
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+inline unsigned long millis() { return (unsigned long)(sitlTimeUs / 1000); }
+inline unsigned long micros() { return (unsigned long)sitlTimeUs; }
+inline void delay(unsigned long ms) { sitlAdvance((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { sitlAdvance(us); }
+
+class Stream {
+public:
+	virtual ~Stream() {}
+	virtual int available() { return 0; }
+	virtual int read() { return -1; }
+	virtual int peek() { return -1; }
+	virtual size_t write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+	virtual size_t write(const uint8_t *buf, size_t len) { return fwrite(buf, 1, len, stdout); }
+	size_t write(const char *buf, size_t len) { return write((const uint8_t *)buf, len); }
+	virtual void flush() { fflush(stdout); }
+	int availableForWrite() { return 256; }
+	size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+		va_list args;
+		va_start(args, format);
+		int n = vprintf(format, args);
+		va_end(args);
+		return n > 0 ? n : 0;
+	}
+	size_t print(const char *s) { return ::printf("%s", s); }
+	size_t print(char c) { return ::printf("%c", c); }
+	size_t print(long n, int base = DEC) { return printNumber(n, base); }
+	size_t print(int n, int base = DEC) { return printNumber(n, base); }
+	size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+	size_t print(unsigned int n, int base = DEC) { return printNumber(n, base); }
+	size_t print(unsigned char n, int base = DEC) { return printNumber(n, base); }
+	size_t print(double n, int digits = 2) { return ::printf("%.*f", digits, n); }
+	template <typename T>
+	size_t println(T v) { return print(v) + println(); }
+	template <typename T>
+	size_t println(T v, int fmt) { return print(v, fmt) + println(); }
+	size_t println() { return ::printf("\n"); }
+
+private:
+	size_t printNumber(long long n, int base) {
+		if (base == HEX) return ::printf("%llX", n);
+		if (base == BIN) {
+			char buf[65];
+			int pos = 64;
+			buf[pos] = '\0';
+			unsigned long long u = n;
+			do {
+				buf[--pos] = '0' + (u & 1);
+				u >>= 1;
+			} while (u);
+			return ::printf("%s", buf + pos);
+		}
+		return ::printf("%lld", n);
+	}
+};
+
+class SerialUART : public Stream {
+public:
+	void begin(unsigned long baud = 115200) {}
+	void end() {}
+	bool setTX(uint8_t pin) { return true; }
+	bool setRX(uint8_t pin) { return true; }
+	bool setFIFOSize(size_t size) { return true; }
+	operator bool() { return true; }
+};
+class SerialUSB : public Stream {
+public:
+	void begin(unsigned long baud = 115200) {}
+	operator bool() { return true; }
+};
+extern SerialUSB Serial;
+extern SerialUART Serial1, Serial2;
+
+class SPIClassRP2040 {
+public:
+	bool setRX(uint8_t pin) { return true; }
+	bool setTX(uint8_t pin) { return true; }
+	bool setSCK(uint8_t pin) { return true; }
+	bool setCS(uint8_t pin) { return true; }
+};
+extern SPIClassRP2040 SPI, SPI1;
+
+/**
+ * @brief Stand-in for the inter-core FIFO and the chip helpers of the Arduino-Pico core
+ * @details The FIFO is pointer wide on the host, so core 1 can still hand heap pointers to core 0
+ */
+class RP2040 {
+public:
+	class Fifo {
+	public:
+		bool push_nb(uintptr_t val);
+		void push(uintptr_t val) { push_nb(val); }
+		uintptr_t pop();
+		bool pop_nb(uintptr_t *val);
+		int available();
+
+	private:
+		uintptr_t buf[8];
+		uint32_t head = 0, tail = 0;
+	};
+	Fifo fifo;
+	void wdt_reset() {}
+	void wdt_begin(uint32_t ms) {}
+	void reboot() { exit(0); }
+	void rebootToBootloader() { exit(0); }
+	uint32_t getCycleCount() { return (uint32_t)(sitlTimeUs * (F_CPU / 1000000)); }
+	uint64_t getCycleCount64() { return sitlTimeUs * (F_CPU / 1000000); }
+	const char *getChipID() { return "SITL0000SITL0000"; }
+	void idleOtherCore() {}
+	void resumeOtherCore() {}
+	uint32_t getFreeHeap() { return 256 * 1024; }
+};
+extern RP2040 rp2040;
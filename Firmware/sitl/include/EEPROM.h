@@ -0,0 +1,28 @@
+#pragma once
+// Host replacement for the EEPROM emulation of the Arduino-Pico core, kept in RAM only
+#include <stdint.h>
+#include <string.h>
+
+class EEPROMClass {
+public:
+	void begin(size_t size) {}
+	bool commit() { return true; }
+	uint8_t read(int address) { return data[address]; }
+	void write(int address, uint8_t val) { data[address] = val; }
+	template <typename T>
+	T &get(int address, T &t) {
+		memcpy(&t, data + address, sizeof(T));
+		return t;
+	}
+	template <typename T>
+	const T &put(int address, const T &t) {
+		memcpy(data + address, &t, sizeof(T));
+		return t;
+	}
+	uint8_t *getDataPtr() { return data; }
+	uint16_t length() { return sizeof(data); }
+
+private:
+	uint8_t data[4096] = {0};
+};
+extern EEPROMClass EEPROM;
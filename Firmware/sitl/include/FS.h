@@ -0,0 +1,49 @@
+#pragma once
+// Host replacement for the FS API of the Arduino-Pico core, files live in a local directory (see SDFS.h)
+#include <Arduino.h>
+
+enum SeekMode {
+	SeekSet = 0,
+	SeekCur = 1,
+	SeekEnd = 2
+};
+
+struct FSInfo {
+	size_t totalBytes;
+	size_t usedBytes;
+	size_t blockSize;
+	size_t pageSize;
+	size_t maxOpenFiles;
+	size_t maxPathLength;
+};
+
+class File : public Stream {
+public:
+	File(FILE *f = nullptr) : f(f) {}
+	size_t write(uint8_t c) override { return f ? fwrite(&c, 1, 1, f) : 0; }
+	size_t write(const uint8_t *buf, size_t len) override { return f ? fwrite(buf, 1, len, f) : 0; }
+	int available() override { return f ? (int)(size() - position()) : 0; }
+	int read() override { return f ? fgetc(f) : -1; }
+	size_t read(uint8_t *buf, size_t len) { return f ? fread(buf, 1, len, f) : 0; }
+	void flush() override {
+		if (f) fflush(f);
+	}
+	bool seek(uint32_t pos, SeekMode mode = SeekSet) { return f && fseek(f, pos, mode) == 0; }
+	size_t position() const { return f ? ftell(f) : 0; }
+	size_t size() const {
+		if (!f) return 0;
+		long pos = ftell(f);
+		fseek(f, 0, SEEK_END);
+		long s = ftell(f);
+		fseek(f, pos, SEEK_SET);
+		return s;
+	}
+	void close() {
+		if (f) fclose(f);
+		f = nullptr;
+	}
+	operator bool() const { return f != nullptr; }
+
+private:
+	FILE *f;
+};
@@ -0,0 +1,30 @@
+#pragma once
+// Host replacement for SDFS of the Arduino-Pico core, maps the card root to the directory set with setRoot() (sitl_sd by default)
+#include "FS.h"
+#include <time.h>
+
+class SDFSConfig {
+public:
+	void setCSPin(uint8_t pin) {}
+	void setSPI(SPIClassRP2040 &spi) {}
+};
+
+class SDFSClass {
+public:
+	void setConfig(const SDFSConfig &cfg) {}
+	void setTimeCallback(time_t (*cb)(void)) {}
+	void setRoot(const char *path) { root = path; }
+	bool begin();
+	void end() {}
+	bool exists(const char *path);
+	bool mkdir(const char *path);
+	bool rmdir(const char *path);
+	bool remove(const char *path);
+	File open(const char *path, const char *mode);
+	bool info(FSInfo &info);
+
+private:
+	const char *root = "sitl_sd";
+	void fullPath(char *buf, size_t len, const char *path);
+};
+extern SDFSClass SDFS;
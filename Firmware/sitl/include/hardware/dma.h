@@ -0,0 +1,41 @@
+#pragma once
+// Host replacement for hardware/dma.h, only the parts the gyro acquisition uses
+// Transfers between memory and the spi0 data register complete instantly in dma_start_channel_mask
+#include "pico/stdlib.h"
+
+enum dma_channel_transfer_size {
+	DMA_SIZE_8 = 0,
+	DMA_SIZE_16 = 1,
+	DMA_SIZE_32 = 2
+};
+
+typedef struct {
+	bool readIncrement, writeIncrement;
+	uint dreq;
+	dma_channel_transfer_size size;
+} dma_channel_config;
+
+typedef struct {
+	/// @brief interrupt status, writing a 1 clears the bit like on the hardware
+	struct Ints {
+		uint32_t bits = 0;
+		operator uint32_t() const { return bits; }
+		Ints &operator=(uint32_t clear) {
+			bits &= ~clear;
+			return *this;
+		}
+	} ints0, ints1;
+} dma_hw_t;
+extern dma_hw_t *const dma_hw;
+
+int dma_claim_unused_channel(bool required);
+dma_channel_config dma_channel_get_default_config(uint channel);
+inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { c->readIncrement = incr; }
+inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { c->writeIncrement = incr; }
+inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { c->dreq = dreq; }
+inline void channel_config_set_transfer_data_size(dma_channel_config *c, dma_channel_transfer_size size) { c->size = size; }
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger);
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+void dma_start_channel_mask(uint32_t chan_mask);
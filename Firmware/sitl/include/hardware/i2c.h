@@ -0,0 +1,7 @@
+#pragma once
+// Host replacement for hardware/i2c.h, nothing of it is simulated
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+extern i2c_inst_t *const i2c0;
+extern i2c_inst_t *const i2c1;
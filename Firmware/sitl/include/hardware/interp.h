@@ -0,0 +1,37 @@
+#pragma once
+// Host replacement for hardware/interp.h, emulates the lane 1 blend mode that the fixed point trig functions use
+#include "pico/stdlib.h"
+
+typedef struct {
+	uint32_t ctrl;
+} interp_config;
+
+#define SIO_INTERP0_CTRL_LANE0_SIGNED_BITS 0x00008000u
+#define SIO_INTERP0_CTRL_LANE0_BLEND_BITS 0x00200000u
+
+struct interp_hw_t {
+	uint32_t accum[2] = {0, 0};
+	uint32_t base[3] = {0, 0, 0};
+	uint32_t ctrl[2] = {0, 0};
+	/// @brief Read-only view of the lane results, computed on access like the hardware does
+	struct Peek {
+		uint32_t operator[](int lane) const;
+	} peek;
+};
+extern interp_hw_t *const interp0;
+extern interp_hw_t *const interp1;
+
+inline interp_config interp_default_config() {
+	interp_config c = {0};
+	return c;
+}
+inline void interp_config_set_blend(interp_config *c, bool blend) {
+	c->ctrl = (c->ctrl & ~SIO_INTERP0_CTRL_LANE0_BLEND_BITS) | (blend ? SIO_INTERP0_CTRL_LANE0_BLEND_BITS : 0);
+}
+inline void interp_config_set_signed(interp_config *c, bool _signed) {
+	c->ctrl = (c->ctrl & ~SIO_INTERP0_CTRL_LANE0_SIGNED_BITS) | (_signed ? SIO_INTERP0_CTRL_LANE0_SIGNED_BITS : 0);
+}
+inline void interp_config_set_shift(interp_config *c, uint shift) {}
+inline void interp_config_set_mask(interp_config *c, uint mask_lsb, uint mask_msb) {}
+inline void interp_config_set_clamp(interp_config *c, bool clamp) {}
+inline void interp_set_config(interp_hw_t *interp, uint lane, interp_config *config) { interp->ctrl[lane] = config->ctrl; }
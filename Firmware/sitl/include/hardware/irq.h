@@ -0,0 +1,11 @@
+#pragma once
+// Host replacement for hardware/irq.h, handlers are called directly by the simulated peripherals
+#include "pico/stdlib.h"
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define IO_IRQ_BANK0 13
+
+typedef void (*irq_handler_t)();
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
@@ -0,0 +1,58 @@
+#pragma once
+// Host replacement for hardware/pio.h
+// Only the FIFOs are simulated: a DShot frame pushed to a state machine queues the telemetry reply from sitlErpmPeriod
+#include "pico/stdlib.h"
+
+struct pio_program {
+	const uint16_t *instructions;
+	uint8_t length;
+	int8_t origin;
+};
+typedef struct {
+	uint32_t clkdiv;
+	uint32_t execctrl;
+	uint32_t shiftctrl;
+	uint32_t pinctrl;
+} pio_sm_config;
+
+struct pio_hw_t;
+typedef pio_hw_t *PIO;
+extern PIO const pio0;
+extern PIO const pio1;
+
+inline pio_sm_config pio_get_default_sm_config() {
+	pio_sm_config c = {0, 0, 0, 0};
+	return c;
+}
+inline void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap) {}
+inline void sm_config_set_out_pins(pio_sm_config *c, uint out_base, uint out_count) {}
+inline void sm_config_set_set_pins(pio_sm_config *c, uint set_base, uint set_count) {}
+inline void sm_config_set_in_pins(pio_sm_config *c, uint in_base) {}
+inline void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) {}
+inline void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs) {}
+inline void sm_config_set_jmp_pin(pio_sm_config *c, uint pin) {}
+inline void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, uint push_threshold) {}
+inline void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold) {}
+inline void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac) {}
+inline void sm_config_set_fifo_join(pio_sm_config *c, int join) {}
+
+inline uint pio_add_program(PIO pio, const pio_program *program) { return 0; }
+inline void pio_claim_sm_mask(PIO pio, uint sm_mask) {}
+inline void pio_gpio_init(PIO pio, uint pin) {}
+inline void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {}
+inline void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {}
+inline void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) {}
+inline void pio_sm_set_clkdiv_int_frac(PIO pio, uint sm, uint16_t div_int, uint8_t div_frac) {}
+inline void pio_sm_set_clkdiv(PIO pio, uint sm, float div) {}
+inline void pio_sm_clear_fifos(PIO pio, uint sm) {}
+inline uint pio_encode_jmp(uint addr) { return addr; }
+/// @brief the simulated state machines always idle at the pull instruction (offset + 2)
+inline uint8_t pio_sm_get_pc(PIO pio, uint sm) { return 2; }
+inline void pio_sm_exec(PIO pio, uint sm, uint instr) {}
+
+void pio_sm_put(PIO pio, uint sm, uint32_t data);
+inline void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data) { pio_sm_put(pio, sm, data); }
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm);
+uint32_t pio_sm_get(PIO pio, uint sm);
+inline uint32_t pio_sm_get_blocking(PIO pio, uint sm) { return pio_sm_get(pio, sm); }
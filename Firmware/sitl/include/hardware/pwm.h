@@ -0,0 +1,3 @@
+#pragma once
+// Host replacement for hardware/pwm.h, nothing of it is simulated
+#include "pico/stdlib.h"
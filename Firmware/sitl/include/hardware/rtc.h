@@ -0,0 +1,18 @@
+#pragma once
+// Host replacement for hardware/rtc.h, the RTC never holds a valid time in the simulation
+#include "pico/stdlib.h"
+
+typedef struct {
+	int16_t year;
+	int8_t month;
+	int8_t day;
+	int8_t dotw;
+	int8_t hour;
+	int8_t min;
+	int8_t sec;
+} datetime_t;
+
+inline void rtc_init() {}
+inline bool rtc_set_datetime(datetime_t *t) { return true; }
+inline bool rtc_get_datetime(datetime_t *t) { return false; }
+inline bool rtc_running() { return false; }
@@ -0,0 +1,14 @@
+#pragma once
+// Host replacement for hardware/structs/systick.h, the counter runs on the virtual clock
+#include "sitl.h"
+
+struct systick_hw_t {
+	uint32_t csr = 0;
+	/// @brief current value, counts down from rvr at F_CPU like the hardware
+	struct Cvr {
+		operator uint32_t() const { return 0xFFFFFF - (uint32_t)(sitlTimeUs * (F_CPU / 1000000) & 0xFFFFFF); }
+		Cvr &operator=(uint32_t) { return *this; }
+	} cvr;
+	uint32_t rvr = 0;
+};
+extern systick_hw_t *const systick_hw;
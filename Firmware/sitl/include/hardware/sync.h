@@ -0,0 +1,24 @@
+#pragma once
+// Host replacement for hardware/sync.h, only the memory barriers, the interrupt masking and the spinlocks
+// Enough for the seqlocks between the simulated cores, which run on the same host thread anyway
+#include <stdint.h>
+
+inline void __dmb() { __atomic_thread_fence(__ATOMIC_ACQ_REL); }
+inline void __dsb() { __atomic_thread_fence(__ATOMIC_ACQ_REL); }
+
+// the simulated interrupts are plain function calls, so there is nothing to mask
+inline uint32_t save_and_disable_interrupts() { return 0; }
+inline void restore_interrupts(uint32_t status) {}
+
+// hardware spinlocks, the simulated cores never run concurrently
+typedef volatile uint32_t spin_lock_t;
+inline int spin_lock_claim_unused(bool required) {
+	static int next = 16;
+	return next++;
+}
+inline spin_lock_t *spin_lock_init(uint32_t lock_num) {
+	static spin_lock_t locks[32];
+	return &locks[lock_num];
+}
+inline uint32_t spin_lock_blocking(spin_lock_t *lock) { return 0; }
+inline void spin_unlock(spin_lock_t *lock, uint32_t saved_irq) {}
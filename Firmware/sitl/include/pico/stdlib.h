@@ -0,0 +1,53 @@
+#pragma once
+// Host replacement for the pico-sdk stdlib, gpio and time functions
+#include "sitl.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define GPIO_IN false
+#define GPIO_OUT true
+enum gpio_function {
+	GPIO_FUNC_XIP = 0,
+	GPIO_FUNC_SPI = 1,
+	GPIO_FUNC_UART = 2,
+	GPIO_FUNC_I2C = 3,
+	GPIO_FUNC_PWM = 4,
+	GPIO_FUNC_SIO = 5,
+	GPIO_FUNC_PIO0 = 6,
+	GPIO_FUNC_PIO1 = 7,
+	GPIO_FUNC_GPCK = 8,
+	GPIO_FUNC_USB = 9,
+	GPIO_FUNC_NULL = 0x1f,
+};
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_pulls(uint gpio, bool up, bool down);
+inline void gpio_pull_up(uint gpio) { gpio_set_pulls(gpio, true, false); }
+inline void gpio_pull_down(uint gpio) { gpio_set_pulls(gpio, false, true); }
+
+enum gpio_irq_level {
+	GPIO_IRQ_LEVEL_LOW = 0x1u,
+	GPIO_IRQ_LEVEL_HIGH = 0x2u,
+	GPIO_IRQ_EDGE_FALL = 0x4u,
+	GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+/// @brief the callback is called by sitlGpioEdge
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback);
+
+/// @brief core the simulation currently runs code for, set by the SITL driver
+extern uint sitlCoreNum;
+inline uint get_core_num() { return sitlCoreNum; }
+
+inline uint32_t time_us_32() { return (uint32_t)sitlTimeUs; }
+inline uint64_t time_us_64() { return sitlTimeUs; }
+inline void sleep_us(uint64_t us) { sitlAdvance(us); }
+inline void sleep_ms(uint32_t ms) { sitlAdvance((uint64_t)ms * 1000); }
+inline void busy_wait_us_32(uint32_t us) { sitlAdvance(us); }
+inline void tight_loop_contents() {}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 264000000L
+#endif
+
+extern uint64_t sitlTimeUs; // virtual time since boot in µs, only advanced by the simulation
+
+/// @brief Advance the virtual clock, used by all sleep and delay functions
+void sitlAdvance(uint64_t us);
+
+/// @brief Simulated 6-axis sample that the fake BMI270 returns on the next data read (raw LSB, accel x, y, z, gyro x, y, z)
+extern int16_t sitlImuSample[6];
+
+/**
+ * @brief Appends sitlImuSample to the FIFO of the fake BMI270 and advances its sensor time by one gyro frame
+ * @details Frames at ACCEL_RATE include the accel. The watermark edge is raised by the caller.
+ */
+void sitlImuPush();
+
+/**
+ * @brief Simulated eRPM telemetry frame that the ESC state machines return after a DShot frame
+ * @details Set to the eeem mmmm mmmm period of the motor, 0xFFF for a stopped motor, or 0xFFFFFFFF to simulate missing telemetry
+ */
+extern uint32_t sitlErpmPeriod[4];
+
+/// @brief Last DShot frames (without inversion) that were sent to the ESCs
+extern uint16_t sitlDshotFrames[4];
+
+/// @brief RC channels that the simulated receiver reports (roll, pitch, throttle, yaw, 988-2012)
+extern uint32_t sitlRcChannels[4];
+
+/// @brief Simulates an edge on a GPIO pin, calls the callback of gpio_set_irq_enabled_with_callback if it is enabled for that edge
+void sitlGpioEdge(unsigned int gpio, bool rising);
+
+/**
+ * @brief Runs the fixed point filters with swept sines, impulses and steps and compares them with the ideal filters
+ * @details See sitl/src/filterResponse.cpp, prints one table per filter.
+ * @return true if all filters are within the bounds
+ */
+bool printFilterResponses();
@@ -0,0 +1,326 @@
+#include <complex>
+#include <functional>
+#include <vector>
+#include "global.h"
+
+/*
+ * Frequency response verifier for the fixed point filters (sitl -F)
+ *
+ * Runs the filter code of src/utils/filters.h with the configurations that the firmware uses, and compares it with the
+ * ideal filter (same design formulas, in double precision):
+ *   - swept sines: gain and phase from a single bin DFT of input and output over whole periods after settling
+ *   - impulse: DC gain (sum of the impulse response) and largest deviation from the ideal impulse response
+ *   - steps up and down: remaining error after settling, shows the dead band of y + alpha * (x - y) with a small alpha
+ * Quantization of alpha or of the coefficients, rounding bias and wrong cutoffs show up as a deviation from the ideal.
+ */
+
+#define RESPONSE_POINTS 16 // swept frequencies per filter
+#define RESPONSE_MAX_ERROR 0.06 // largest |H - H ideal|, about 0.5 dB or 3.4 deg in the pass band
+#define RESPONSE_MAX_DC_ERROR 0.01 // relative DC gain error of the impulse response
+#define RESPONSE_MAX_STEP_ERROR 0.005 // remaining step error relative to the step
+
+typedef std::complex<double> cplx;
+
+/// @brief second order section of the ideal filter, normalized to a0 = 1
+typedef struct idealSection {
+	double b0, b1, b2, a1, a2;
+} IdealSection;
+
+typedef struct filterCase {
+	const char *name;
+	u32 sampleFreq;
+	f32 freq; // cutoff or center frequency, the sweep goes from freq / 10 to 10 * freq (freq / 4 to 4 * freq for notches)
+	bool notch;
+	f32 amplitude; // input amplitude in the unit of the filtered value
+	std::vector<IdealSection> ideal;
+	std::function<std::function<fix32(fix32)>()> make; // returns a new filter with cleared state
+} FilterCase;
+
+static IdealSection idealPt1(double cutoffFreq, double sampleFreq) {
+	// same approximation as pt1Alpha
+	const double omega = 2 * M_PI * cutoffFreq / sampleFreq;
+	const double alpha = omega / (omega + 1);
+	return {alpha, 0, 0, alpha - 1, 0};
+}
+
+static IdealSection idealBiquad(BiquadType type, double freq, double q, double sampleFreq) {
+	// same formulas as biquadCoeffs
+	const double omega = 2 * M_PI * freq / sampleFreq;
+	const double cs = cos(omega);
+	const double alpha = sin(omega) / (2 * q);
+	const double a0 = 1 + alpha;
+	IdealSection s;
+	switch (type) {
+	case BiquadType::LOWPASS:
+		s.b0 = (1 - cs) / 2 / a0;
+		s.b1 = (1 - cs) / a0;
+		s.b2 = s.b0;
+		break;
+	case BiquadType::NOTCH:
+		s.b0 = 1 / a0;
+		s.b1 = -2 * cs / a0;
+		s.b2 = s.b0;
+		break;
+	case BiquadType::BANDPASS:
+		s.b0 = alpha / a0;
+		s.b1 = 0;
+		s.b2 = -s.b0;
+		break;
+	}
+	s.a1 = -2 * cs / a0;
+	s.a2 = (1 - alpha) / a0;
+	return s;
+}
+
+static cplx idealResponse(const std::vector<IdealSection> &sections, double omega) {
+	const cplx z1 = std::polar(1.0, -omega), z2 = z1 * z1;
+	cplx h = 1;
+	for (const IdealSection &s : sections)
+		h *= (s.b0 + s.b1 * z1 + s.b2 * z2) / (1.0 + s.a1 * z1 + s.a2 * z2);
+	return h;
+}
+
+/// @brief samples until the slowest pole of the ideal filter decayed to 1e-5
+static u32 settleSamples(const std::vector<IdealSection> &sections) {
+	double r = 0;
+	for (const IdealSection &s : sections) {
+		// pole radius: |a1| for a first order section, sqrt(a2) for complex poles, larger real pole otherwise
+		double p;
+		if (s.a2 == 0)
+			p = fabs(s.a1);
+		else if (s.a1 * s.a1 < 4 * s.a2)
+			p = sqrt(s.a2);
+		else
+			p = (fabs(s.a1) + sqrt(s.a1 * s.a1 - 4 * s.a2)) / 2;
+		if (p > r) r = p;
+	}
+	if (r <= 0) return 16;
+	return (u32)(log(1e-5) / log(r)) * sections.size() + 16;
+}
+
+/// @brief the ideal filter in the time domain, for the impulse response
+class IdealFilter {
+public:
+	IdealFilter(const std::vector<IdealSection> &sections) : sections(sections), state(sections.size() * 4, 0) {}
+	double update(double x) {
+		for (size_t i = 0; i < sections.size(); i++) {
+			const IdealSection &s = sections[i];
+			double *st = &state[i * 4]; // x1, x2, y1, y2
+			const double y = s.b0 * x + s.b1 * st[0] + s.b2 * st[1] - s.a1 * st[2] - s.a2 * st[3];
+			st[1] = st[0];
+			st[0] = x;
+			st[3] = st[2];
+			st[2] = y;
+			x = y;
+		}
+		return x;
+	}
+
+private:
+	std::vector<IdealSection> sections;
+	std::vector<double> state;
+};
+
+static inline fix32 toFix(double v) {
+	return fix32().setRaw((i32)llround(v * 65536));
+}
+
+/// @brief notch with the coefficients of notchCoeffsFix, as used by the RPM filter and the dynamic notch
+typedef struct fixNotch {
+	i32 b0, a1, a2;
+	fix32 x1, x2, y1, y2;
+	fix32 update(fix32 x) { return notchStep(x, b0, a1, a2, x1, x2, y1, y2); }
+} FixNotch;
+
+static FixNotch makeNotch(fix32 freq, fix32 q, u32 sampleFreq) {
+	FixNotch n;
+	startFixTrig();
+	notchCoeffsFix(freq, q, sampleFreq, n.b0, n.a1, n.a2);
+	return n;
+}
+
+static std::vector<FilterCase> filterCases() {
+	std::vector<FilterCase> c;
+	c.push_back({"PT1 magHeadingCorrection (imu.cpp)", 75, .02f, false, 1, {idealPt1(.02, 75)}, [] {
+					 return [f = PT1(.02, 75)](fix32 x) mutable { return f.update(x); };
+				 }});
+	c.push_back({"PT1 motor frequency (rpmFilter.cpp)", 3200, RPM_FILTER_FREQ_CUTOFF, false, 300, {idealPt1(RPM_FILTER_FREQ_CUTOFF, 3200)}, [] {
+					 return [f = PT1(RPM_FILTER_FREQ_CUTOFF, 3200)](fix32 x) mutable { return f.update(x); };
+				 }});
+	c.push_back({"PT1 vVelDFilter (pid.cpp)", 3200, 15, false, 1, {idealPt1(15, 3200)}, [] {
+					 return [f = PT1(15, 3200)](fix32 x) mutable { return f.update(x); };
+				 }});
+	c.push_back({"PT1 vVelFFFilter (pid.cpp)", 3200, 2, false, 1, {idealPt1(2, 3200)}, [] {
+					 return [f = PT1(2, 3200)](fix32 x) mutable { return f.update(x); };
+				 }});
+	c.push_back({"PT1N<3> accelDataFiltered (imu.cpp)", ACCEL_RATE, 100, false, 2048, {idealPt1(100, ACCEL_RATE)}, [] {
+					 return [f = PT1N<3>(100, ACCEL_RATE)](fix32 x) mutable {
+						 const fix32 v[3] = {x, x, x};
+						 f.update(v);
+						 return f[0];
+					 };
+				 }});
+	const int dtermFreqs[2] = {DTERM_LPF_MIN, DTERM_LPF_MAX};
+	static char dtermNames[2][64];
+	for (int i = 0; i < 2; i++) {
+		const int freq = dtermFreqs[i];
+		snprintf(dtermNames[i], sizeof(dtermNames[i]), "PT1N<3> dFilter LUT %d Hz (pid.cpp)", freq);
+		c.push_back({dtermNames[i], 3200, (f32)freq, false, 100, {idealPt1(freq, 3200)}, [freq] {
+						 PT1N<3> f(DTERM_LPF_MIN, 3200);
+						 f.updateCutoffFreqLut(freq);
+						 return [f](fix32 x) mutable {
+							 const fix32 v[3] = {x, x, x};
+							 f.update(v);
+							 return f[0];
+						 };
+					 }});
+	}
+	c.push_back({"PT2 100 Hz", 3200, 100, false, 100, {idealPt1(100 * 1.553773974, 3200), idealPt1(100 * 1.553773974, 3200)}, [] {
+					 return [f = PT2(100, 3200)](fix32 x) mutable { return f.update(x); };
+				 }});
+	const IdealSection pt3Stage = idealPt1(100 * 1.961459177, 3200);
+	c.push_back({"PT3 100 Hz", 3200, 100, false, 100, {pt3Stage, pt3Stage, pt3Stage}, [] {
+					 return [f = PT3(100, 3200)](fix32 x) mutable { return f.update(x); };
+				 }});
+	const int gyroFreqs[2] = {GYRO_LPF_MIN, GYRO_LPF_MAX};
+	static char gyroNames[2][64];
+	for (int i = 0; i < 2; i++) {
+		const int freq = gyroFreqs[i];
+		snprintf(gyroNames[i], sizeof(gyroNames[i]), "BiquadN<3> gyroFilter LUT %d Hz (pid.cpp)", freq);
+		c.push_back({gyroNames[i], 3200, (f32)freq, false, 100, {idealBiquad(BiquadType::LOWPASS, freq, BIQUAD_Q_BUTTERWORTH, 3200)}, [freq] {
+						 BiquadN<3> f(BiquadType::LOWPASS, GYRO_LPF_MIN, 3200);
+						 f.updateLowpassLut(freq);
+						 return [f](fix32 x) mutable {
+							 fix32 v[3] = {x, x, x};
+							 f.update(v);
+							 return v[0];
+						 };
+					 }});
+	}
+	c.push_back({"Biquad low pass 20 Hz", 3200, 20, false, 100, {idealBiquad(BiquadType::LOWPASS, 20, BIQUAD_Q_BUTTERWORTH, 3200)}, [] {
+					 return [f = Biquad(BiquadType::LOWPASS, 20, 3200)](fix32 x) mutable { return f.update(x); };
+				 }});
+	const int rpmFreqs[2] = {RPM_FILTER_MIN_FREQ, 333};
+	static char rpmNames[2][64];
+	for (int i = 0; i < 2; i++) {
+		const int freq = rpmFreqs[i];
+		snprintf(rpmNames[i], sizeof(rpmNames[i]), "RPM notch %d Hz (rpmFilter.cpp)", freq);
+		c.push_back({rpmNames[i], 3200, (f32)freq, true, 100, {idealBiquad(BiquadType::NOTCH, freq, RPM_FILTER_Q, 3200)}, [freq] {
+						 return [f = makeNotch(freq, RPM_FILTER_Q, 3200)](fix32 x) mutable { return f.update(x); };
+					 }});
+	}
+	const int dynFreqs[2] = {DYN_NOTCH_MIN_FREQ, DYN_NOTCH_MAX_FREQ};
+	static char dynNames[2][64];
+	for (int i = 0; i < 2; i++) {
+		const int freq = dynFreqs[i];
+		snprintf(dynNames[i], sizeof(dynNames[i]), "Dynamic notch %d Hz (dynNotch.cpp)", freq);
+		c.push_back({dynNames[i], 3200, (f32)freq, true, 100, {idealBiquad(BiquadType::NOTCH, freq, DYN_NOTCH_Q, 3200)}, [freq] {
+						 return [f = makeNotch(freq, DYN_NOTCH_Q, 3200)](fix32 x) mutable { return f.update(x); };
+					 }});
+	}
+	return c;
+}
+
+/**
+ * @brief gain and phase of the fixed point filter at one frequency
+ * @param freq requested frequency, changed to the nearest one with a whole number of periods in the DFT window
+ */
+static cplx measureResponse(const FilterCase &fc, std::function<fix32(fix32)> filter, u32 settle, double &freq) {
+	const double periods = std::max(3.0, ceil(4096 * freq / fc.sampleFreq));
+	const u32 window = (u32)llround(periods * fc.sampleFreq / freq);
+	freq = periods * fc.sampleFreq / window;
+	const double omega = 2 * M_PI * freq / fc.sampleFreq;
+	cplx in = 0, out = 0;
+	for (u32 n = 0; n < settle + window; n++) {
+		const fix32 x = toFix(fc.amplitude * sin(omega * n));
+		const fix32 y = filter(x);
+		if (n < settle) continue;
+		const cplx w = std::polar(1.0, -omega * (n - settle));
+		in += x.getf64() * w;
+		out += y.getf64() * w;
+	}
+	return out / in;
+}
+
+static inline double toDb(double gain) {
+	return 20 * log10(std::max(gain, 1e-9));
+}
+
+static inline double toDeg(cplx h) {
+	return std::arg(h) * 180 / M_PI;
+}
+
+/// @brief runs all checks of one filter, returns false if one of them is out of bounds
+static bool checkFilter(const FilterCase &fc) {
+	const u32 settle = settleSamples(fc.ideal);
+	printf("\n%s, %u Hz sample rate, amplitude %g\n", fc.name, fc.sampleFreq, fc.amplitude);
+	printf("%10s %9s %9s %9s %9s %8s\n", "Hz", "dB", "ideal dB", "deg", "ideal deg", "error");
+
+	// swept sines
+	const double lo = fc.freq / (fc.notch ? 4 : 10);
+	const double hi = std::min((double)fc.freq * (fc.notch ? 4 : 10), fc.sampleFreq * 0.45);
+	double maxError = 0, maxErrorFreq = 0;
+	for (int i = 0; i < RESPONSE_POINTS; i++) {
+		double freq = lo * pow(hi / lo, (double)i / (RESPONSE_POINTS - 1));
+		const cplx h = measureResponse(fc, fc.make(), settle, freq);
+		const cplx ideal = idealResponse(fc.ideal, 2 * M_PI * freq / fc.sampleFreq);
+		const double error = std::abs(h - ideal);
+		if (error > maxError) {
+			maxError = error;
+			maxErrorFreq = freq;
+		}
+		printf("%10.4g %9.2f %9.2f %9.1f %9.1f %8.4f%s\n", freq, toDb(std::abs(h)), toDb(std::abs(ideal)), toDeg(h), toDeg(ideal), error, error > RESPONSE_MAX_ERROR ? " !" : "");
+	}
+
+	// impulse
+	std::function<fix32(fix32)> filter = fc.make();
+	IdealFilter ideal(fc.ideal);
+	const fix32 impulse = toFix(fc.amplitude);
+	double sum = 0, idealSum = 0, peak = 0, maxDeviation = 0;
+	for (u32 n = 0; n < settle; n++) {
+		const fix32 x = n ? fix32(0) : impulse;
+		const double y = filter(x).getf64();
+		const double yIdeal = ideal.update(x.getf64());
+		sum += y;
+		idealSum += yIdeal;
+		peak = std::max(peak, fabs(yIdeal));
+		maxDeviation = std::max(maxDeviation, fabs(y - yIdeal));
+	}
+	const double dcError = (sum - idealSum) / impulse.getf64();
+
+	// steps up and down, the remaining error after settling
+	filter = fc.make();
+	fix32 y;
+	for (u32 n = 0; n < 2 * settle; n++)
+		y = filter(impulse);
+	const double stepUpError = (y - impulse).getf64() / impulse.getf64();
+	for (u32 n = 0; n < 2 * settle; n++)
+		y = filter(0);
+	const double stepDownError = y.getf64() / impulse.getf64();
+
+	printf("max error %.4f at %.4g Hz, impulse: DC gain error %+.3f %%, max deviation %.2f %% of peak\n", maxError, maxErrorFreq, dcError * 100, maxDeviation / peak * 100);
+	printf("step up: %+.4f %%, step down: %+.4f %% remaining after %u samples\n", stepUpError * 100, stepDownError * 100, 2 * settle);
+	bool ok = true;
+	if (maxError > RESPONSE_MAX_ERROR) {
+		printf("CHECK: response deviates from the ideal filter\n");
+		ok = false;
+	}
+	if (fabs(dcError) > RESPONSE_MAX_DC_ERROR) {
+		printf("CHECK: DC gain deviates from the ideal filter\n");
+		ok = false;
+	}
+	if (fabs(stepUpError) > RESPONSE_MAX_STEP_ERROR || fabs(stepDownError) > RESPONSE_MAX_STEP_ERROR) {
+		printf("CHECK: output does not settle at the input, dead band of the fixed point update\n");
+		ok = false;
+	}
+	return ok;
+}
+
+bool printFilterResponses() {
+	const std::vector<FilterCase> cases = filterCases();
+	u32 failed = 0;
+	for (const FilterCase &fc : cases)
+		if (!checkFilter(fc)) failed++;
+	printf("\n%u of %u filters deviate from the ideal response\n", failed, (u32)cases.size());
+	return failed == 0;
+}
@@ -0,0 +1,426 @@
+#include <deque>
+#include <vector>
+#include "global.h"
+#include "hardware/structs/systick.h"
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Simulated hardware for the host build: virtual clock, GPIO, SPI with a BMI270, DMA, PIO FIFOs with eRPM telemetry, interpolator and SD card
+
+uint64_t sitlTimeUs = 0;
+i16 sitlImuSample[6] = {0, 0, 2048, 0, 0, 0};
+u32 sitlErpmPeriod[4] = {0xFFF, 0xFFF, 0xFFF, 0xFFF};
+u16 sitlDshotFrames[4] = {0};
+uint sitlCoreNum = 0;
+
+void sitlAdvance(uint64_t us) {
+	sitlTimeUs += us;
+}
+
+SerialUSB Serial;
+SerialUART Serial1, Serial2;
+SPIClassRP2040 SPI, SPI1;
+RP2040 rp2040;
+EEPROMClass EEPROM;
+SDFSClass SDFS;
+
+bool RP2040::Fifo::push_nb(uintptr_t val) {
+	if (head - tail >= ARRAYLEN(buf)) return false;
+	buf[head++ % ARRAYLEN(buf)] = val;
+	return true;
+}
+uintptr_t RP2040::Fifo::pop() {
+	if (head == tail) return 0;
+	return buf[tail++ % ARRAYLEN(buf)];
+}
+bool RP2040::Fifo::pop_nb(uintptr_t *val) {
+	if (head == tail) return false;
+	*val = pop();
+	return true;
+}
+int RP2040::Fifo::available() {
+	return head - tail;
+}
+
+// ================= GPIO =================
+static bool gpioOut[30] = {0};
+
+void gpio_init(uint gpio) {}
+void gpio_set_dir(uint gpio, bool out) {}
+void gpio_set_function(uint gpio, enum gpio_function fn) {}
+void gpio_set_pulls(uint gpio, bool up, bool down) {}
+
+struct spi_inst {
+	u32 id;
+};
+static spi_inst spiInstances[2] = {{0}, {1}};
+spi_inst_t *const spi0 = &spiInstances[0];
+spi_inst_t *const spi1 = &spiInstances[1];
+
+static void bmiSelect(bool selected);
+void gpio_put(uint gpio, bool value) {
+	if (gpio >= 30) return;
+	if (gpio == PIN_GYRO_CS && gpioOut[gpio] != value)
+		bmiSelect(!value);
+	gpioOut[gpio] = value;
+}
+
+static gpio_irq_callback_t gpioIrqCallback = nullptr;
+static u32 gpioIrqMask[30] = {0};
+
+void gpio_set_irq_enabled_with_callback(uint gpio, u32 event_mask, bool enabled, gpio_irq_callback_t callback) {
+	if (gpio >= 30) return;
+	if (enabled)
+		gpioIrqMask[gpio] |= event_mask;
+	else
+		gpioIrqMask[gpio] &= ~event_mask;
+	gpioIrqCallback = callback;
+}
+
+void sitlGpioEdge(uint gpio, bool rising) {
+	const u32 event = rising ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+	if (gpio < 30 && gpioIrqCallback && (gpioIrqMask[gpio] & event))
+		gpioIrqCallback(gpio, event);
+}
+
+bool gpio_get(uint gpio) {
+	if (gpio == PIN_GYRO_INT1) {
+		// FIFO watermark, high for the first 50 µs of every PID loop
+		return (sitlTimeUs * 1000) % 312500 < 50000;
+	}
+	if (gpio < 30) return gpioOut[gpio];
+	return false;
+}
+
+// ================= SPI / BMI270 =================
+static u8 bmiRegs[128] = {0};
+static bool bmiSelected = false, bmiExpectAddr = false, bmiReading = false, bmiDummyPending = false;
+static u8 bmiAddr = 0;
+
+// FIFO in header mode, frames are only removed once they were read completely
+#define BMI_FIFO_SIZE 2048
+static std::deque<std::vector<u8>> bmiFifo;
+static u32 bmiFifoBytes = 0, bmiFifoSkipped = 0, bmiFifoPushes = 0;
+static u32 bmiSensorTime = 0; // 24 bits, 39.0625 µs per tick
+static u32 bmiFifoFrame = 0, bmiFifoPos = 0, bmiTimeFramePos = 0; // read position within the current transaction
+
+void sitlImuPush() {
+	bmiSensorTime = (bmiSensorTime + GYRO_FRAME_TICKS) & 0xFFFFFF;
+	std::vector<u8> frame;
+	// the accel runs at ACCEL_RATE
+	const bool accel = bmiFifoPushes++ % (3200 * GYRO_OVERSAMPLING / ACCEL_RATE) == 0;
+	frame.push_back(accel ? (u8)GyroFifoHeader::GYRO_ACCEL : (u8)GyroFifoHeader::GYRO);
+	const u8 *s = (const u8 *)sitlImuSample;
+	frame.insert(frame.end(), s + 6, s + 12);
+	if (accel) frame.insert(frame.end(), s, s + 6);
+	bmiFifo.push_back(frame);
+	bmiFifoBytes += frame.size();
+	while (bmiFifoBytes > BMI_FIFO_SIZE) {
+		// overwrite the oldest frames, a skip frame tells how many were lost
+		bmiFifoBytes -= bmiFifo.front().size();
+		bmiFifo.pop_front();
+		bmiFifoSkipped++;
+	}
+}
+
+static u8 bmiFifoRead() {
+	if (bmiFifoSkipped) {
+		const u8 skipFrame[2] = {(u8)GyroFifoHeader::SKIP, (u8)std::min(bmiFifoSkipped, 255u)};
+		const u8 b = skipFrame[bmiFifoPos++];
+		if (bmiFifoPos == 2) {
+			bmiFifoSkipped = 0;
+			bmiFifoPos = 0;
+		}
+		return b;
+	}
+	if (bmiFifoFrame < bmiFifo.size()) {
+		const std::vector<u8> &frame = bmiFifo[bmiFifoFrame];
+		const u8 b = frame[bmiFifoPos++];
+		if (bmiFifoPos == frame.size()) {
+			bmiFifoFrame++;
+			bmiFifoPos = 0;
+		}
+		return b;
+	}
+	// beyond the fill level: sensor time frame, then over-read bytes
+	const u8 timeFrame[4] = {(u8)GyroFifoHeader::TIME, (u8)bmiSensorTime, (u8)(bmiSensorTime >> 8), (u8)(bmiSensorTime >> 16)};
+	if (bmiTimeFramePos < 4) return timeFrame[bmiTimeFramePos++];
+	return (u8)GyroFifoHeader::OVER_READ;
+}
+
+static void bmiSelect(bool selected) {
+	if (!selected) {
+		// completely read frames leave the FIFO, a partially read one is sent again
+		for (; bmiFifoFrame; bmiFifoFrame--) {
+			bmiFifoBytes -= bmiFifo.front().size();
+			bmiFifo.pop_front();
+		}
+		bmiFifoPos = 0;
+		bmiTimeFramePos = 0;
+	}
+	bmiSelected = selected;
+	bmiExpectAddr = selected;
+	bmiReading = false;
+}
+
+static u8 bmiReadReg(u8 reg) {
+	switch (reg) {
+	case (u8)GyroReg::CHIP_ID:
+		return 0x24;
+	case (u8)GyroReg::INTERNAL_STATUS:
+		return 0x01;
+	default:
+		return bmiRegs[reg & 0x7F];
+	}
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate) { return baudrate; }
+void spi_deinit(spi_inst_t *spi) {}
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) { return baudrate; }
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order) {}
+
+int spi_write_blocking(spi_inst_t *spi, const u8 *src, size_t len) {
+	if (spi != SPI_GYRO || !bmiSelected || !len) return len;
+	size_t i = 0;
+	if (bmiExpectAddr) {
+		bmiExpectAddr = false;
+		bmiAddr = src[i] & 0x7F;
+		bmiReading = src[i] & 0x80;
+		bmiDummyPending = bmiReading;
+		i++;
+		if (bmiReading && bmiAddr == (u8)GyroReg::ACC_X_LSB)
+			memcpy(&bmiRegs[bmiAddr], sitlImuSample, sizeof(sitlImuSample)); // latch the sample like the shadowing of the data registers
+	}
+	if (!bmiReading && i < len && bmiAddr != (u8)GyroReg::INIT_DATA)
+		bmiRegs[bmiAddr] = src[len - 1];
+	return len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, u8 repeated_tx_data, u8 *dst, size_t len) {
+	if (spi != SPI_GYRO || !bmiSelected || !bmiReading) {
+		memset(dst, 0, len);
+		return len;
+	}
+	for (size_t i = 0; i < len; i++) {
+		if (bmiDummyPending) {
+			bmiDummyPending = false;
+			dst[i] = 0xFF;
+			continue;
+		}
+		dst[i] = bmiAddr == (u8)GyroReg::FIFO_DATA ? bmiFifoRead() : bmiReadReg(bmiAddr++);
+	}
+	return len;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const u8 *src, u8 *dst, size_t len) {
+	spi_write_blocking(spi, src, len);
+	return spi_read_blocking(spi, 0, dst, len);
+}
+
+static spi_hw_t spiHw[2];
+spi_hw_t *spi_get_hw(spi_inst_t *spi) { return &spiHw[spi->id]; }
+
+// ================= IRQ / DMA =================
+static irq_handler_t irqHandlers[32] = {nullptr};
+static bool irqEnabled[32] = {false};
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) { irqHandlers[num] = handler; }
+void irq_set_enabled(uint num, bool enabled) { irqEnabled[num] = enabled; }
+
+struct DmaChannel {
+	dma_channel_config config;
+	const volatile u8 *read;
+	volatile u8 *write;
+	u32 count;
+	bool irq1;
+};
+static DmaChannel dmaChannels[12];
+static u32 dmaClaimed = 0;
+static dma_hw_t dmaHwInstance;
+dma_hw_t *const dma_hw = &dmaHwInstance;
+
+int dma_claim_unused_channel(bool required) {
+	for (int i = 0; i < 12; i++) {
+		if (!(dmaClaimed & 1 << i)) {
+			dmaClaimed |= 1 << i;
+			return i;
+		}
+	}
+	return -1;
+}
+dma_channel_config dma_channel_get_default_config(uint channel) {
+	return {true, false, 0x3F, DMA_SIZE_32};
+}
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, uint transfer_count, bool trigger) {
+	dmaChannels[channel] = {*config, (const volatile u8 *)read_addr, (volatile u8 *)write_addr, transfer_count, dmaChannels[channel].irq1};
+	if (trigger) dma_start_channel_mask(1 << channel);
+}
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+	dmaChannels[channel].read = (const volatile u8 *)read_addr;
+	if (trigger) dma_start_channel_mask(1 << channel);
+}
+void dma_channel_set_write_addr(uint channel, volatile void *write_addr, bool trigger) {
+	dmaChannels[channel].write = (volatile u8 *)write_addr;
+	if (trigger) dma_start_channel_mask(1 << channel);
+}
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) { dmaChannels[channel].irq1 = enabled; }
+
+/// @brief runs an 8 bit SPI transfer between a TX and an RX channel, byte by byte through the simulated devices
+static void dmaSpiTransfer(spi_inst_t *spi, DmaChannel &tx, DmaChannel &rx) {
+	u8 txBuf[64], rxBuf[64];
+	u32 count = tx.count < rx.count ? tx.count : rx.count;
+	if (count > sizeof(txBuf)) count = sizeof(txBuf);
+	for (u32 i = 0; i < count; i++)
+		txBuf[i] = tx.read[tx.config.readIncrement ? i : 0];
+	// the simulated devices take the first byte as the command and answer the rest
+	spi_write_blocking(spi, txBuf, 1);
+	rxBuf[0] = 0;
+	if (count > 1) spi_read_blocking(spi, 0, rxBuf + 1, count - 1);
+	for (u32 i = 0; i < count; i++)
+		rx.write[rx.config.writeIncrement ? i : 0] = rxBuf[i];
+}
+
+void dma_start_channel_mask(u32 chan_mask) {
+	for (int s = 0; s < 2; s++) {
+		spi_inst_t *spi = s ? spi1 : spi0;
+		int tx = -1, rx = -1;
+		for (int c = 0; c < 12; c++) {
+			if (!(chan_mask & 1 << c)) continue;
+			if (dmaChannels[c].config.dreq == spi_get_dreq(spi, true)) tx = c;
+			if (dmaChannels[c].config.dreq == spi_get_dreq(spi, false)) rx = c;
+		}
+		if (tx < 0 || rx < 0) continue;
+		dmaSpiTransfer(spi, dmaChannels[tx], dmaChannels[rx]);
+		for (int c : {tx, rx})
+			if (dmaChannels[c].irq1) dma_hw->ints1.bits |= 1 << c;
+	}
+	if (dma_hw->ints1 && irqEnabled[DMA_IRQ_1] && irqHandlers[DMA_IRQ_1])
+		irqHandlers[DMA_IRQ_1]();
+}
+
+struct i2c_inst {
+	u32 id;
+};
+static i2c_inst i2cInstances[2] = {{0}, {1}};
+i2c_inst_t *const i2c0 = &i2cInstances[0];
+i2c_inst_t *const i2c1 = &i2cInstances[1];
+
+// ================= SysTick =================
+static systick_hw_t systickInstance;
+systick_hw_t *const systick_hw = &systickInstance;
+
+// ================= Interpolator =================
+static interp_hw_t interpInstances[2];
+interp_hw_t *const interp0 = &interpInstances[0];
+interp_hw_t *const interp1 = &interpInstances[1];
+
+u32 interp_hw_t::Peek::operator[](int lane) const {
+	const interp_hw_t *hw = (const interp_hw_t *)((const u8 *)this - offsetof(interp_hw_t, peek));
+	if (lane == 1 && (hw->ctrl[0] & SIO_INTERP0_CTRL_LANE0_BLEND_BITS)) {
+		// result = base0 + alpha * (base1 - base0) / 256, alpha being the lower 8 bits of accum1
+		i64 alpha = hw->accum[1] & 0xFF;
+		if (hw->ctrl[1] & SIO_INTERP0_CTRL_LANE0_SIGNED_BITS)
+			return (u32)((i32)hw->base[0] + ((alpha * ((i64)(i32)hw->base[1] - (i32)hw->base[0])) >> 8));
+		return (u32)(hw->base[0] + ((alpha * ((i64)hw->base[1] - (i64)hw->base[0])) >> 8));
+	}
+	return hw->accum[lane] + hw->base[lane];
+}
+
+// ================= PIO / DShot =================
+struct pio_hw_t {
+	u32 rxFifo[4][4];
+	u32 rxCount[4];
+};
+static pio_hw_t pioInstances[2];
+PIO const pio0 = &pioInstances[0];
+PIO const pio1 = &pioInstances[1];
+
+static u32 gcrEncodeLut[16];
+
+/// @brief encodes a telemetry value the way the bidirectional DShot program returns it (GCR, edge coded)
+static u32 encodeErpmReply(u32 period) {
+	static bool lutReady = false;
+	if (!lutReady) {
+		for (u32 code = 0; code < 32; code++)
+			if (escDecodeLut[code] < 16) gcrEncodeLut[escDecodeLut[code]] = code;
+		lutReady = true;
+	}
+	u32 csum = ~(period ^ (period >> 4) ^ (period >> 8)) & 0xF;
+	u32 value = period << 4 | csum;
+	u32 gcr = 0;
+	for (int i = 3; i >= 0; i--)
+		gcr = gcr << 5 | gcrEncodeLut[(value >> (i * 4)) & 0xF];
+	// undo the edge detection of decodeErpm: v ^ (v >> 1) = gcr
+	gcr ^= gcr >> 1;
+	gcr ^= gcr >> 2;
+	gcr ^= gcr >> 4;
+	gcr ^= gcr >> 8;
+	gcr ^= gcr >> 16;
+	return gcr;
+}
+
+void pio_sm_put(PIO pio, uint sm, u32 data) {
+	if (pio != ESC_PIO || sm >= 4) return;
+	sitlDshotFrames[sm] = ~data;
+	if (sitlErpmPeriod[sm] == 0xFFFFFFFF) return;
+	if (pio->rxCount[sm] < 4)
+		pio->rxFifo[sm][pio->rxCount[sm]++] = encodeErpmReply(sitlErpmPeriod[sm] & 0xFFF);
+}
+
+bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+	return pio->rxCount[sm] == 0;
+}
+
+bool pio_sm_is_tx_fifo_full(PIO pio, uint sm) {
+	return false;
+}
+
+u32 pio_sm_get(PIO pio, uint sm) {
+	if (!pio->rxCount[sm]) return 0;
+	u32 v = pio->rxFifo[sm][0];
+	memmove(pio->rxFifo[sm], pio->rxFifo[sm] + 1, sizeof(u32) * 3);
+	pio->rxCount[sm]--;
+	return v;
+}
+
+// ================= SD card =================
+void SDFSClass::fullPath(char *buf, size_t len, const char *path) {
+	snprintf(buf, len, "%s%s%s", root, path[0] == '/' ? "" : "/", path);
+}
+bool SDFSClass::begin() {
+	::mkdir(root, 0755);
+	struct stat st;
+	return stat(root, &st) == 0;
+}
+bool SDFSClass::exists(const char *path) {
+	char p[256];
+	fullPath(p, sizeof(p), path);
+	struct stat st;
+	return stat(p, &st) == 0;
+}
+bool SDFSClass::mkdir(const char *path) {
+	char p[256];
+	fullPath(p, sizeof(p), path);
+	return ::mkdir(p, 0755) == 0;
+}
+bool SDFSClass::rmdir(const char *path) {
+	char p[256];
+	fullPath(p, sizeof(p), path);
+	return ::rmdir(p) == 0;
+}
+bool SDFSClass::remove(const char *path) {
+	char p[256];
+	fullPath(p, sizeof(p), path);
+	return ::remove(p) == 0;
+}
+File SDFSClass::open(const char *path, const char *mode) {
+	char p[256];
+	fullPath(p, sizeof(p), path);
+	char m[4];
+	snprintf(m, sizeof(m), "%sb", mode);
+	return File(fopen(p, m));
+}
+bool SDFSClass::info(FSInfo &info) {
+	memset(&info, 0, sizeof(info));
+	info.totalBytes = 1ULL << 30;
+	return true;
+}
@@ -0,0 +1,265 @@
+#include "global.h"
+#include <chrono>
+
+/*
+ * Software in the loop driver
+ *
+ * Runs the core 1 path (FIFO watermark edge -> DMA burst read -> gyroLoop -> pidLoop -> ESC output -> blackbox frame) and the core 0 consumers
+ * (blackboxLoop, taskManagerLoop through the scheduler) on a virtual clock, as fast as the host allows.
+ * The gyro FIFO is fed either with a deterministic synthetic signal or with a CSV replay (ax,ay,az,gx,gy,gz raw LSB per line, one
+ * line per gyro sample, so GYRO_OVERSAMPLING lines per PID loop).
+ * The DShot frames are hashed, so that changes in the control path show up as a different checksum.
+ *
+ * Usage: sitl [-n cycles] [-r replay.csv] [-a] [-t throttle] [-m rpm] [-b] [-T trace.ktrc] [-S us] [-B] [-F]
+ *   -n  number of PID loops to run (default 32000 = 10 s)
+ *   -r  replay raw IMU samples from a CSV file (wraps around)
+ *   -a  arm after the gyro calibration finished
+ *   -t  throttle channel while armed (1000-2000, default 1300)
+ *   -m  simulated motor rpm for the eRPM telemetry (default 0 = stopped)
+ *   -b  log all blackbox fields to sitl_sd/kolibri/
+ *   -T  capture a task trace after the calibration, convert it with python/traceToChrome.py
+ *   -S  once per second, hold spi0 and stall core 1 for this long (like a slow OSD transfer), the FIFO keeps the samples
+ *   -B  run the micro-benchmarks (src/benchmark.h) instead of the simulation
+ *   -F  compare the fixed point filters with the ideal filters (sitl/src/filterResponse.cpp) instead of the simulation
+ */
+
+#define SITL_GYRO_PERIOD_NS 312500
+#define SITL_CALIBRATION_CYCLES (CALIBRATION_SAMPLES + QUIET_SAMPLES + 10)
+
+static u32 rng = 0x12345678;
+static i16 noise(i16 amplitude) {
+	rng ^= rng << 13;
+	rng ^= rng >> 17;
+	rng ^= rng << 5;
+	return (i16)(rng % (2 * amplitude + 1)) - amplitude;
+}
+
+/// @brief synthetic IMU data for gyro sample n (GYRO_OVERSAMPLING samples per PID loop)
+static void syntheticSample(u32 n, i16 sample[6]) {
+	sample[0] = noise(20);
+	sample[1] = noise(20);
+	sample[2] = 2048 + noise(20);
+	if (n < SITL_CALIBRATION_CYCLES * GYRO_OVERSAMPLING) {
+		// quiet while the gyro calibrates, the bias on z keeps the samples away from the all -1 error pattern
+		sample[3] = noise(8);
+		sample[4] = noise(8);
+		sample[5] = 12 + noise(8);
+		return;
+	}
+	// slow stick-like movements with motor noise on top
+	f32 t = n * (SITL_GYRO_PERIOD_NS / 1e9f / GYRO_OVERSAMPLING);
+	sample[3] = (i16)(800 * sinf(t * 2 * PI * 0.7f)) + noise(60);
+	sample[4] = (i16)(500 * sinf(t * 2 * PI * 1.3f + 1)) + noise(60);
+	sample[5] = 12 + (i16)(300 * sinf(t * 2 * PI * 0.4f + 2)) + noise(60);
+}
+
+static bool replaySample(FILE *f, i16 sample[6]) {
+	int v[6];
+	char line[128];
+	for (int tries = 0; tries < 2; tries++) {
+		while (fgets(line, sizeof(line), f)) {
+			if (sscanf(line, "%d,%d,%d,%d,%d,%d", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) == 6) {
+				for (int i = 0; i < 6; i++)
+					sample[i] = v[i];
+				return true;
+			}
+		}
+		rewind(f);
+	}
+	return false;
+}
+
+/// @brief condensed eRPM period (eeem mmmm mmmm) for a mechanical rpm, 0xFFF for a stopped motor
+static u32 rpmToPeriod(u32 rpm) {
+	if (!rpm) return 0xFFF;
+	u32 period = 60000000 / (rpm * (MOTOR_POLES / 2));
+	u32 e = 0;
+	while (period > 0x1FF) {
+		period >>= 1;
+		e++;
+	}
+	return e << 9 | period;
+}
+
+// the core 0 part of the host build, same settings as in main.cpp
+static SchedulerTask core0Tasks[] = {
+	{blackboxLoop, [] { return rp2040.fifo.available() && bbLogging && fsReady; }, TASK_BLACKBOX, 7, 0, 200},
+	{dynNotchLoop, dynNotchSamplesAvailable, TASK_DYN_NOTCH, 4, 0, 100},
+	{taskManagerLoop, nullptr, TASK_TASKMANAGER, 1, 1000000, 20},
+};
+
+/// @brief writes both trace buffers in the .ktrc format of python/traceToChrome.py
+static bool writeTrace(const char *path) {
+	FILE *f = fopen(path, "wb");
+	if (!f) return false;
+	const u32 header[3] = {0x4352544B, 1 | 2 << 8, F_CPU}; // "KTRC", version 1, 2 cores
+	fwrite(header, sizeof(header), 1, f);
+	for (int c = 0; c < 2; c++) {
+		const TraceBuffer &t = traceBuffers[c];
+		const u32 core[3] = {t.syncCycles, t.syncUs, t.count};
+		fwrite(core, sizeof(core), 1, f);
+		fwrite(t.events, sizeof(TraceEvent), t.count, f);
+	}
+	fclose(f);
+	return true;
+}
+
+int main(int argc, char **argv) {
+	u32 cycles = 32000;
+	const char *replayPath = nullptr, *tracePath = nullptr;
+	bool arm = false, logBlackbox = false, benchmark = false, filterResponse = false;
+	u32 throttleChannel = 1300, motorRpm = 0, stallCycles = 0;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc)
+			cycles = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+			replayPath = argv[++i];
+		else if (!strcmp(argv[i], "-a"))
+			arm = true;
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			throttleChannel = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "-m") && i + 1 < argc)
+			motorRpm = strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(argv[i], "-b"))
+			logBlackbox = true;
+		else if (!strcmp(argv[i], "-T") && i + 1 < argc)
+			tracePath = argv[++i];
+		else if (!strcmp(argv[i], "-S") && i + 1 < argc)
+			stallCycles = (strtoul(argv[++i], nullptr, 10) * 1000 + SITL_GYRO_PERIOD_NS - 1) / SITL_GYRO_PERIOD_NS;
+		else if (!strcmp(argv[i], "-B"))
+			benchmark = true;
+		else if (!strcmp(argv[i], "-F"))
+			filterResponse = true;
+		else {
+			printf("Usage: %s [-n cycles] [-r replay.csv] [-a] [-t throttle] [-m rpm] [-b] [-T trace.ktrc] [-S us] [-B] [-F]\n", argv[0]);
+			return 2;
+		}
+	}
+	FILE *replay = nullptr;
+	if (replayPath) {
+		replay = fopen(replayPath, "r");
+		if (!replay) {
+			printf("Cannot open %s\n", replayPath);
+			return 2;
+		}
+	}
+
+	// same order as setup(), limited to the modules of the host build
+	initCycleCounter();
+	updateLoopTime();
+	runUnitTests();
+	initPID();
+	initDefaultSpi();
+	if (gyroInit()) return 1;
+	imuInit();
+	initESCs();
+	initTaskManager();
+	ELRS = new ExpressLRS(Serial1, 420000, PIN_TX0, PIN_RX0);
+	initBlackbox();
+	if (logBlackbox) {
+		bbFlags = 0x7FFFFFFFFFFULL;
+		bbFreqDivider = 1;
+	}
+	for (int m = 0; m < 4; m++)
+		sitlErpmPeriod[m] = rpmToPeriod(motorRpm);
+	sitlCoreNum = 1;
+	updateLoopTime();
+	gyroStartAcquisition();
+	if (benchmark) {
+		printBenchmarks();
+		return 0;
+	}
+	if (filterResponse) return printFilterResponses() ? 0 : 1;
+
+	u64 minNs = UINT64_MAX, maxNs = 0, totalNs = 0;
+	u32 pidRuns = 0;
+	bool spiHeld = false;
+	u64 hash = 0xcbf29ce484222325ULL; // FNV-1a over all DShot frames
+	auto wallStart = std::chrono::steady_clock::now();
+	for (u32 cycle = 0; cycle < cycles; cycle++) {
+		if (cycle == SITL_CALIBRATION_CYCLES && tracePath) traceStart();
+		if (cycle == SITL_CALIBRATION_CYCLES && arm) {
+			if (armingDisableFlags & 0x40) {
+				printf("Gyro calibration did not finish\n");
+				return 1;
+			}
+			armed = true;
+			sitlRcChannels[2] = throttleChannel;
+			if (logBlackbox) startLogging();
+		}
+
+		// a blocking transfer on spi0 holds back the FIFO reads and core 1 does not run gyroLoop
+		const bool stalled = stallCycles && cycle > SITL_CALIBRATION_CYCLES && cycle % 3200 < stallCycles;
+		if (stalled && !spiHeld) spiAcquire(SPI_GYRO);
+		if (!stalled && spiHeld) spiRelease(SPI_GYRO);
+		spiHeld = stalled;
+
+		// GYRO_OVERSAMPLING gyro frames per PID loop, the last one reaches the FIFO watermark
+		for (u32 s = 0; s < GYRO_OVERSAMPLING; s++) {
+			const u32 sample = cycle * GYRO_OVERSAMPLING + s;
+			sitlTimeUs = ((u64)sample * SITL_GYRO_PERIOD_NS / GYRO_OVERSAMPLING + 999) / 1000;
+			if (!replay || !replaySample(replay, sitlImuSample))
+				syntheticSample(sample, sitlImuSample);
+			sitlImuPush();
+		}
+
+		// rising edge of the watermark interrupt
+		sitlCoreNum = 1;
+		updateLoopTime();
+		TaskSnapshot before, after;
+		readTaskStats(TASK_GYROREAD, before);
+		auto t0 = std::chrono::steady_clock::now();
+		sitlGpioEdge(PIN_GYRO_INT1, true); // starts the DMA read, which completes right away
+		if (!stalled) gyroLoop();
+		auto t1 = std::chrono::steady_clock::now();
+		readTaskStats(TASK_GYROREAD, after);
+		if (after.runCounter != before.runCounter) {
+			u64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+			if (ns < minNs) minNs = ns;
+			if (ns > maxNs) maxNs = ns;
+			totalNs += ns;
+			pidRuns++;
+		}
+
+		// falling edge
+		sitlTimeUs += 60;
+		updateLoopTime();
+		sitlGpioEdge(PIN_GYRO_INT1, false);
+		if (!stalled) gyroLoop();
+		for (int m = 0; m < 4; m++) {
+			hash ^= sitlDshotFrames[m];
+			hash *= 0x100000001b3ULL;
+		}
+
+		// the core 0 consumers
+		sitlCoreNum = 0;
+		updateLoopTime();
+		schedulerLoop(core0Tasks, ARRAYLEN(core0Tasks));
+	}
+	auto wallEnd = std::chrono::steady_clock::now();
+	if (logBlackbox) {
+		while (rp2040.fifo.available())
+			blackboxLoop();
+		endLogging();
+	}
+
+	if (tracePath && !writeTrace(tracePath)) {
+		printf("Cannot write %s\n", tracePath);
+		return 2;
+	}
+
+	f64 wallS = std::chrono::duration<f64>(wallEnd - wallStart).count();
+	f64 simS = cycles * (SITL_GYRO_PERIOD_NS / 1e9);
+	printf("\n ================ SITL results ================ \n");
+	printf("Cycles:          %u (%.2f s simulated, %.3f s wall, %.0fx real time)\n", cycles, simS, wallS, simS / wallS);
+	if (pidRuns)
+		printf("gyroLoop (host): min %llu ns, avg %llu ns, max %llu ns over %u runs\n", (unsigned long long)minNs, (unsigned long long)(totalNs / pidRuns), (unsigned long long)maxNs, pidRuns);
+	printf("Attitude:        roll %.4f, pitch %.4f, yaw %.4f rad\n", roll.getf32(), pitch.getf32(), yaw.getf32());
+	printf("Throttles:       %d %d %d %d\n", throttles[0], throttles[1], throttles[2], throttles[3]);
+	printf("eRPM:            %u %u %u %u rpm, fail flags 0x%X, decode errors %u\n", escRpm[0], escRpm[1], escRpm[2], escRpm[3], escErpmFail, tasks[TASK_ESC_RPM].errorCount);
+	printf("Gyro:            %u samples dropped, last error %u, sensor time tick %.4f us\n", tasks[TASK_GYROREAD].errorCount, tasks[TASK_GYROREAD].lastError, gyroTickUs.getf32());
+	printf("DShot checksum:  %016llX\n", (unsigned long long)hash);
+	printf(" ============================================== \n");
+	if (replay) fclose(replay);
+	return 0;
+}
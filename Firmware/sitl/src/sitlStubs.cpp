@@ -0,0 +1,42 @@
+#include "global.h"
+
+// Definitions of the modules that are not part of the host build (RC link, GPS, baro, mag, MSP, RTC)
+
+u32 sitlRcChannels[4] = {1500, 1500, 1000, 1500};
+
+bool armed = false;
+u32 armingDisableFlags = 0;
+
+ExpressLRS::ExpressLRS(SerialUART &elrsSerial, u32 baudrate, u8 pinTX, u8 pinRX)
+	: elrsSerial(elrsSerial), pinTX(pinTX), pinRX(pinRX), baudrate(baudrate) {
+	elrsStream = &elrsSerial;
+	isLinkUp = true;
+	isReceiverUp = true;
+}
+ExpressLRS::~ExpressLRS() {}
+void ExpressLRS::loop() {}
+void ExpressLRS::getSmoothChannels(fix32 smoothChannels[4]) {
+	for (int i = 0; i < 4; i++)
+		smoothChannels[i] = (i32)sitlRcChannels[i];
+}
+
+GpsStatus gpsStatus;
+GpsMotion gpsMotion;
+u8 currentPvtMsg[92];
+u32 newPvtMessageFlag = 0;
+
+f32 baroUpVel = 0;
+fix32 gpsBaroAlt;
+
+fix32 magHeading = 0;
+i32 magRunCounter = 0;
+
+u8 accelCalDone = 0;
+ElapsedLoopMillis mspOverrideMotors = 1001;
+void sendMsp(u8 serialNum, MspMsgType type, MspFn fn, MspVersion version, const char *data, u16 len) {}
+
+u32 rtcGetBlackboxTimestamp() { return 0; }
+
+// size_t is 64 bits wide on the host
+template <>
+const char *Fmt<unsigned long>::f = "%16lu";
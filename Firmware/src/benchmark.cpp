@@ -0,0 +1,384 @@
+#include "global.h"
+#ifdef SITL
+#include <chrono>
+#endif
+
+// inputs and outputs of the kernels, volatile so that the compiler can neither hoist the kernel out of the loop nor drop it
+static volatile i32 benchIn[4] = {0x00012345, 0x0000C000, -0x00008765, 0x00004000};
+static volatile f32 benchInF[6] = {0.6f, 0.0f, 0.8f, 0.0f, 0.0f, 1.0f};
+static volatile i32 benchOut;
+static volatile i64 benchOut64;
+static volatile f32 benchOutF;
+
+#ifdef SITL
+/// @brief host time converted to cycles at F_CPU
+static u32 benchClock() {
+	u64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	return ns * (F_CPU / 1000000) / 1000;
+}
+#else
+static u32 benchClock() {
+	return cycleCount();
+}
+#endif
+
+static void benchEmpty(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut = benchIn[0] + benchIn[1];
+}
+
+static void benchFix32Mul(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut = (fix32().setRaw(benchIn[0]) * fix32().setRaw(benchIn[1])).raw;
+}
+
+static void benchFix32Div(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut = (fix32().setRaw(benchIn[0]) / fix32().setRaw(benchIn[1])).raw;
+}
+
+static void benchFix64Mul(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut64 = (fix64().setRaw((i64)benchIn[0] << 16) * fix64().setRaw((i64)benchIn[2] << 16)).raw;
+}
+
+static void benchFix64Div(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut64 = (fix64().setRaw((i64)benchIn[0] << 16) / fix32().setRaw(benchIn[1])).raw;
+}
+
+static void benchFix64MulFix32(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut64 = (fix64().setRaw((i64)benchIn[2] << 16) * fix32().setRaw(benchIn[1])).raw;
+}
+
+static void benchLongMul(u32 n) {
+	// what GCC emits for a widening multiply (__aeabi_lmul on the M0+)
+	for (u32 i = 0; i < n; i++)
+		benchOut64 = (i64)benchIn[0] * benchIn[2];
+}
+
+static void benchSmul32x32(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut64 = smul32x32(benchIn[0], benchIn[2]);
+}
+
+static void benchFix32AddSat(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut = fix32().setRaw(benchIn[0]).addSat(fix32().setRaw(benchIn[2])).raw;
+}
+
+static void benchFix32MulSat(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut = fix32().setRaw(benchIn[0]).mulSat(fix32().setRaw(benchIn[1])).raw;
+}
+
+static void benchSinFix(u32 n) {
+	startFixTrig();
+	for (u32 i = 0; i < n; i++)
+		benchOut = sinFix(fix32().setRaw(benchIn[2])).raw;
+}
+
+static void benchCosFix(u32 n) {
+	startFixTrig();
+	for (u32 i = 0; i < n; i++)
+		benchOut = cosFix(fix32().setRaw(benchIn[2])).raw;
+}
+
+static void benchAtan2Fix(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOut = atan2Fix(fix32().setRaw(benchIn[2]), fix32().setRaw(benchIn[1])).raw;
+}
+
+static void benchAsinFix(u32 n) {
+	startFixTrig();
+	for (u32 i = 0; i < n; i++)
+		benchOut = asinFix(fix32().setRaw(benchIn[1])).raw;
+}
+
+static void benchAcosFix(u32 n) {
+	startFixTrig();
+	for (u32 i = 0; i < n; i++)
+		benchOut = acosFix(fix32().setRaw(benchIn[2])).raw;
+}
+
+static void benchSqrtFix(u32 n) {
+	startFixTrig();
+	for (u32 i = 0; i < n; i++)
+		benchOut = sqrtFix(fix32().setRaw(benchIn[0])).raw;
+}
+
+static void benchInvSqrtFix(u32 n) {
+	startFixTrig();
+	for (u32 i = 0; i < n; i++)
+		benchOut = invSqrtFix(fix32().setRaw(benchIn[0])).raw;
+}
+
+static void benchF32Mul(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOutF = benchInF[0] * benchInF[2];
+}
+
+static void benchF32Div(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOutF = benchInF[0] / benchInF[2];
+}
+
+static void benchSqrtf(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOutF = sqrtf(benchInF[0]);
+}
+
+static void benchSinf(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOutF = sinf(benchInF[0]);
+}
+
+static void benchAsinf(u32 n) {
+	// float reference for asinFix, the pitch calculation of updatePitchRollValues
+	for (u32 i = 0; i < n; i++)
+		benchOutF = asinf(benchInF[0]);
+}
+
+static void benchAcosf(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOutF = acosf(benchInF[0]);
+}
+
+static void benchInvSqrtf(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOutF = 1 / sqrtf(benchInF[0]);
+}
+
+static void benchAtan2f(u32 n) {
+	for (u32 i = 0; i < n; i++)
+		benchOutF = atan2f(benchInF[0], benchInF[2]);
+}
+
+static void benchPT1(u32 n) {
+	static PT1 filter(100, 3200);
+	for (u32 i = 0; i < n; i++)
+		benchOut = filter.update(fix32().setRaw(benchIn[0])).raw;
+}
+
+static void benchPT3(u32 n) {
+	static PT3 filter(100, 3200);
+	for (u32 i = 0; i < n; i++)
+		benchOut = filter.update(fix32().setRaw(benchIn[0])).raw;
+}
+
+static void benchBiquad(u32 n) {
+	static Biquad filter(BiquadType::LOWPASS, 100, 3200);
+	for (u32 i = 0; i < n; i++)
+		benchOut = filter.update(fix32().setRaw(benchIn[0])).raw;
+}
+
+static void benchBiquadF(u32 n) {
+	static BiquadF filter(BiquadType::LOWPASS, 100, 3200);
+	for (u32 i = 0; i < n; i++)
+		benchOutF = filter.update(benchInF[0]);
+}
+
+static void benchBiquadX3(u32 n) {
+	static Biquad filters[3] = {Biquad(BiquadType::LOWPASS, 100, 3200), Biquad(BiquadType::LOWPASS, 100, 3200), Biquad(BiquadType::LOWPASS, 100, 3200)};
+	for (u32 i = 0; i < n; i++)
+		for (int ax = 0; ax < 3; ax++)
+			benchOut = filters[ax].update(fix32().setRaw(benchIn[ax])).raw;
+}
+
+static void benchBiquadN(u32 n) {
+	static BiquadN<3> filter(BiquadType::LOWPASS, 100, 3200);
+	for (u32 i = 0; i < n; i++) {
+		fix32 data[3] = {fix32().setRaw(benchIn[0]), fix32().setRaw(benchIn[1]), fix32().setRaw(benchIn[2])};
+		filter.update(data);
+		benchOut = data[0].raw;
+	}
+}
+
+static void benchPT1Cutoff(u32 n) {
+	static PT1 filter(100, 3200);
+	for (u32 i = 0; i < n; i++)
+		filter.updateCutoffFreq(fix32().setRaw(benchIn[0] << 10));
+}
+
+static void benchPT1CutoffLut(u32 n) {
+	static PT1 filter(100, 3200);
+	for (u32 i = 0; i < n; i++)
+		filter.updateCutoffFreqLut(fix32().setRaw(benchIn[0] << 10));
+}
+
+static void benchBiquadLowpassLut(u32 n) {
+	static Biquad filter(BiquadType::LOWPASS, 100, 3200);
+	for (u32 i = 0; i < n; i++)
+		filter.updateLowpassLut(fix32().setRaw(benchIn[0] << 10));
+}
+
+static void benchQuaternionNormalize(u32 n) {
+	Quaternion q;
+	for (u32 i = 0; i < n; i++) {
+		Quaternion_set(benchInF[0], benchInF[1], benchInF[2], benchInF[0], &q);
+		Quaternion_normalize(&q, &q);
+		benchOutF = q.w;
+	}
+}
+
+static void benchQuaternionFixNormalize(u32 n) {
+	QuaternionFix q;
+	for (u32 i = 0; i < n; i++) {
+		q.w = benchIn[1] << 14;
+		q.v[0] = benchIn[3] << 14;
+		q.v[1] = benchIn[2] << 14;
+		q.v[2] = benchIn[3] << 14;
+		QuaternionFix_normalize(&q);
+		benchOut = q.w;
+	}
+}
+
+static void benchQuatFixInvSqrt(u32 n) {
+	startFixTrig();
+	i32 halfShift;
+	for (u32 i = 0; i < n; i++)
+		benchOut = quatFixInvSqrt(benchIn[0], &halfShift);
+}
+
+static void benchQuaternionFromUnitVecs(u32 n) {
+	Quaternion q;
+	for (u32 i = 0; i < n; i++) {
+		const f32 v0[3] = {benchInF[0], benchInF[1], benchInF[2]};
+		const f32 v1[3] = {benchInF[3], benchInF[4], benchInF[5]};
+		Quaternion_from_unit_vecs(v0, v1, &q);
+		benchOutF = q.w;
+	}
+}
+
+static void benchDecodeErpm(u32 n) {
+	// valid telemetry of a motor at 20000 rpm (period 0x1AC, 14 poles), as the DShot state machine returns it
+	static const u32 frame = 0x00093293;
+	for (u32 i = 0; i < n; i++) {
+		for (int m = 0; m < 4; m++)
+			decodeErpmFrame(m, frame ^ benchIn[3] >> 20);
+		benchOut = escRpm[0];
+	}
+}
+
+static void benchWriteSingleFrame(u32 n) {
+	// the encoding of a frame with all fields, without the file or FIFO handling
+	static u8 frame[128];
+	for (u32 i = 0; i < n; i++)
+		benchOut = encodeBlackboxFrame(frame, 0x7FFFFFFFFFFULL);
+}
+
+const Benchmark benchmarks[] = {
+	{"empty kernel", benchEmpty, 1000},
+	{"fix32 * fix32", benchFix32Mul, 1000},
+	{"fix32 / fix32", benchFix32Div, 1000},
+	{"fix64 * fix64", benchFix64Mul, 1000},
+	{"fix64 * fix32", benchFix64MulFix32, 1000},
+	{"fix64 / fix32", benchFix64Div, 500},
+	{"(i64)i32 * i32", benchLongMul, 1000},
+	{"smul32x32", benchSmul32x32, 1000},
+	{"fix32 addSat", benchFix32AddSat, 1000},
+	{"fix32 mulSat", benchFix32MulSat, 1000},
+	{"sinFix", benchSinFix, 1000},
+	{"cosFix", benchCosFix, 1000},
+	{"atan2Fix", benchAtan2Fix, 500},
+	{"asinFix", benchAsinFix, 500},
+	{"acosFix", benchAcosFix, 500},
+	{"sqrtFix", benchSqrtFix, 500},
+	{"invSqrtFix", benchInvSqrtFix, 500},
+	{"f32 * f32", benchF32Mul, 500},
+	{"f32 / f32", benchF32Div, 500},
+	{"sqrtf", benchSqrtf, 200},
+	{"sinf", benchSinf, 200},
+	{"asinf", benchAsinf, 200},
+	{"acosf", benchAcosf, 200},
+	{"1 / sqrtf", benchInvSqrtf, 200},
+	{"atan2f", benchAtan2f, 200},
+	{"PT1::update", benchPT1, 1000},
+	{"PT3::update", benchPT3, 1000},
+	{"Biquad::update", benchBiquad, 500},
+	{"BiquadF::update", benchBiquadF, 200},
+	{"Biquad::update x3", benchBiquadX3, 200},
+	{"BiquadN<3>::update", benchBiquadN, 200},
+	{"PT1::updateCutoffFreq", benchPT1Cutoff, 500},
+	{"PT1::updateCutoffFreqLut", benchPT1CutoffLut, 500},
+	{"Biquad::updateLowpassLut", benchBiquadLowpassLut, 500},
+	{"Quaternion_normalize", benchQuaternionNormalize, 200},
+	{"QuaternionFix_normalize", benchQuaternionFixNormalize, 500},
+	{"quatFixInvSqrt", benchQuatFixInvSqrt, 500},
+	{"Quaternion_from_unit_vecs", benchQuaternionFromUnitVecs, 100},
+	{"decodeErpm (4 frames)", benchDecodeErpm, 500},
+	{"writeSingleFrame (all)", benchWriteSingleFrame, 100},
+};
+const u32 benchmarkCount = ARRAYLEN(benchmarks);
+static_assert(ARRAYLEN(benchmarks) <= BENCHMARK_MAX_COUNT, "increase BENCHMARK_MAX_COUNT");
+
+/// @brief fastest of BENCHMARK_REPEATS measurements in cycles
+static u32 measure(const Benchmark &b) {
+	u32 best = 0xFFFFFFFF;
+	for (int r = 0; r < BENCHMARK_REPEATS; r++) {
+		const u32 irq = save_and_disable_interrupts();
+		const u32 start = benchClock();
+		b.run(b.iterations);
+		const u32 cycles = benchClock() - start;
+		restore_interrupts(irq);
+		rp2040.wdt_reset(); // a full run takes about as long as the watchdog period
+		if (cycles < best) best = cycles;
+	}
+	return best;
+}
+
+void runBenchmarks(BenchmarkResult *results) {
+	// the first entry is the empty kernel, it is reported as measured and subtracted from all others
+	const u32 overhead = measure(benchmarks[0]);
+	results[0].cycles = overhead;
+	results[0].iterations = benchmarks[0].iterations;
+	for (u32 i = 1; i < benchmarkCount; i++) {
+		const Benchmark &b = benchmarks[i];
+		const u32 cycles = measure(b);
+		const u32 loop = (u64)overhead * b.iterations / benchmarks[0].iterations;
+		results[i].cycles = cycles > loop ? cycles - loop : 0;
+		results[i].iterations = b.iterations;
+	}
+}
+
+// request from the other core, cleared by benchmarkLoop when the results are written
+static BenchmarkResult *volatile benchmarkRequest[2] = {nullptr, nullptr};
+
+bool runBenchmarksOnCore(u8 core, BenchmarkResult *results) {
+	if (core == get_core_num()) {
+		runBenchmarks(results);
+		return true;
+	}
+	benchmarkRequest[core] = results;
+	const u32 start = millis();
+	while (benchmarkRequest[core]) {
+		rp2040.wdt_reset(); // the other core only feeds it between its measurements
+		if (millis() - start > 2000) {
+			benchmarkRequest[core] = nullptr;
+			return false;
+		}
+	}
+	return true;
+}
+
+void benchmarkLoop() {
+	BenchmarkResult *results = benchmarkRequest[get_core_num()];
+	if (!results) return;
+	runBenchmarks(results);
+	benchmarkRequest[get_core_num()] = nullptr;
+}
+
+void printBenchmarks() {
+	static BenchmarkResult results[ARRAYLEN(benchmarks)];
+	runBenchmarks(results);
+	Serial.println();
+	Serial.printf(" ================ Benchmarks (core %d) ================ \n", get_core_num());
+	Serial.printf("%-28s %12s %12s\n", "Kernel", "cycles/call", "ns/call");
+	for (u32 i = 1; i < benchmarkCount; i++) {
+		const f32 perCall = (f32)results[i].cycles / results[i].iterations;
+		Serial.printf("%-28s %12.1f %12.1f\n", benchmarks[i].name, perCall, perCall * 1e9f / F_CPU);
+	}
+	Serial.printf("(empty kernel: %.1f cycles/call, subtracted from all)\n", (f32)results[0].cycles / results[0].iterations);
+	Serial.println(" ====================================================== ");
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "typedefs.h"
+
+/*
+ * Micro-benchmarks
+ *
+ * Times the math kernels of the control path with the cycle counter of the calling core, so that optimizations can be
+ * compared against a baseline. Every kernel reads its inputs from volatile memory and writes its result to volatile memory,
+ * the cost of that (the empty kernel) is subtracted from all results.
+ * On the target the results are cycles at F_CPU (MSP BENCHMARK, on either core and with interrupts masked during every
+ * measurement), in the host build the host time is converted to cycles at F_CPU (sitl -B), so only the relative numbers of
+ * a host run are meaningful. The host FPU in particular hides the cost of the software float of the Cortex-M0+.
+ */
+
+/// @brief one entry of the benchmark list
+typedef struct benchmark {
+	const char *name;
+	void (*run)(u32 iterations); // calls the kernel iterations times
+	u16 iterations; // calls per measurement, chosen to keep a measurement below 10 ms on the target
+} Benchmark;
+
+/// @brief result of one benchmark, the fastest of BENCHMARK_REPEATS measurements
+typedef struct benchmarkResult {
+	u32 cycles; // cycles for all iterations, without the loop overhead (except for the first entry, the empty kernel)
+	u16 iterations; // calls of the kernel
+} BenchmarkResult;
+
+#define BENCHMARK_REPEATS 5 // measurements per benchmark, the fastest one counts
+#define BENCHMARK_MAX_COUNT 48 // size of the result buffers, names up to 33 characters fit the MSP response
+
+extern const Benchmark benchmarks[];
+extern const u32 benchmarkCount;
+
+/**
+ * @brief runs all benchmarks on the calling core
+ * @details Interrupts are masked during every measurement (not in between), so a measurement has to stay far below the
+ * 63 ms of the cycle counter.
+ * @param results benchmarkCount entries
+ */
+void runBenchmarks(BenchmarkResult *results);
+
+/**
+ * @brief runs all benchmarks on the given core and waits for the results
+ * @details For the other core, the request is picked up by benchmarkLoop, which has to be called in that core's loop.
+ * @param core 0 or 1
+ * @param results benchmarkCount entries
+ * @return true if the benchmarks ran, false if the other core did not finish within 2 seconds
+ */
+bool runBenchmarksOnCore(u8 core, BenchmarkResult *results);
+
+/// @brief runs the benchmarks that the other core requested for this core, called in loop1
+void benchmarkLoop();
+
+/// @brief runs all benchmarks and prints a table with the cycles and the time per call to Serial
+void printBenchmarks();
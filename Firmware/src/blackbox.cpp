@@ -16,24 +16,14 @@ File blackboxFile;
 
 i32 maxFileSize = 0;
 u32 bbFrameNum = 0, newestPvtStartedAt = 0;
-elapsedMicros frametime;
+ElapsedLoopMicros frametime;
 void blackboxLoop() {
 	if (rp2040.fifo.available() && bbLogging && fsReady) {
-		elapsedMicros taskTimer = 0;
-		tasks[TASK_BLACKBOX].runCounter++;
 		u8 *frame = (u8 *)rp2040.fifo.pop();
 		u8 len = frame[0];
 		if (len > 0 && bbLogging)
 			blackboxFile.write(frame + 1, len);
 		free(frame);
-		u32 duration = taskTimer;
-		tasks[TASK_BLACKBOX].totalDuration += duration;
-		if (duration < tasks[TASK_BLACKBOX].minDuration) {
-			tasks[TASK_BLACKBOX].minDuration = duration;
-		}
-		if (duration > tasks[TASK_BLACKBOX].maxDuration) {
-			tasks[TASK_BLACKBOX].maxDuration = duration;
-		}
 	}
 }
 
@@ -213,130 +203,120 @@ void endLogging() {
 	bbLogging = false;
 }
 
-void __not_in_flash_func(writeSingleFrame)() {
-	u8 *bbBuffer = (u8 *)malloc(128);
+size_t __not_in_flash_func(encodeBlackboxFrame)(u8 *bbBuffer, u64 flags) {
 	size_t bufferPos = 1;
-	if (!fsReady || !bbLogging) {
-		return;
-	}
-#if BLACKBOX_STORAGE == LITTLEFS
-	if (blackboxFile.size() > maxFileSize) {
-		endLogging();
-		return;
-	}
-#endif
-	if (currentBBFlags & LOG_ROLL_ELRS_RAW) {
+	if (flags & LOG_ROLL_ELRS_RAW) {
 		bbBuffer[bufferPos++] = ELRS->channels[0];
 		bbBuffer[bufferPos++] = ELRS->channels[0] >> 8;
 	}
-	if (currentBBFlags & LOG_PITCH_ELRS_RAW) {
+	if (flags & LOG_PITCH_ELRS_RAW) {
 		bbBuffer[bufferPos++] = ELRS->channels[1];
 		bbBuffer[bufferPos++] = ELRS->channels[1] >> 8;
 	}
-	if (currentBBFlags & LOG_THROTTLE_ELRS_RAW) {
+	if (flags & LOG_THROTTLE_ELRS_RAW) {
 		bbBuffer[bufferPos++] = ELRS->channels[2];
 		bbBuffer[bufferPos++] = ELRS->channels[2] >> 8;
 	}
-	if (currentBBFlags & LOG_YAW_ELRS_RAW) {
+	if (flags & LOG_YAW_ELRS_RAW) {
 		bbBuffer[bufferPos++] = ELRS->channels[3];
 		bbBuffer[bufferPos++] = ELRS->channels[3] >> 8;
 	}
-	if (currentBBFlags & LOG_ROLL_SETPOINT) {
+	if (flags & LOG_ROLL_SETPOINT) {
 		i16 setpoint = (i16)(rollSetpoint.raw >> 12);
 		bbBuffer[bufferPos++] = setpoint;
 		bbBuffer[bufferPos++] = setpoint >> 8;
 	}
-	if (currentBBFlags & LOG_PITCH_SETPOINT) {
+	if (flags & LOG_PITCH_SETPOINT) {
 		i16 setpoint = (i16)(pitchSetpoint.raw >> 12);
 		bbBuffer[bufferPos++] = setpoint;
 		bbBuffer[bufferPos++] = setpoint >> 8;
 	}
-	if (currentBBFlags & LOG_THROTTLE_SETPOINT) {
+	if (flags & LOG_THROTTLE_SETPOINT) {
 		i16 t = (i16)(throttle.raw >> 12);
 		bbBuffer[bufferPos++] = t;
 		bbBuffer[bufferPos++] = t >> 8;
 	}
-	if (currentBBFlags & LOG_YAW_SETPOINT) {
+	if (flags & LOG_YAW_SETPOINT) {
 		i16 setpoint = (i16)(yawSetpoint.raw >> 12);
 		bbBuffer[bufferPos++] = setpoint;
 		bbBuffer[bufferPos++] = setpoint >> 8;
 	}
-	if (currentBBFlags & LOG_ROLL_GYRO_RAW) {
+	if (flags & LOG_ROLL_GYRO_RAW) {
 		i16 i = (gyroData[AXIS_ROLL].raw >> 12);
 		bbBuffer[bufferPos++] = i;
 		bbBuffer[bufferPos++] = i >> 8;
 	}
-	if (currentBBFlags & LOG_PITCH_GYRO_RAW) {
+	if (flags & LOG_PITCH_GYRO_RAW) {
 		i16 i = (gyroData[AXIS_PITCH].raw >> 12);
 		bbBuffer[bufferPos++] = i;
 		bbBuffer[bufferPos++] = i >> 8;
 	}
-	if (currentBBFlags & LOG_YAW_GYRO_RAW) {
+	if (flags & LOG_YAW_GYRO_RAW) {
 		i16 i = (gyroData[AXIS_YAW].raw >> 12);
 		bbBuffer[bufferPos++] = i;
 		bbBuffer[bufferPos++] = i >> 8;
 	}
-	if (currentBBFlags & LOG_ROLL_PID_P) {
+	if (flags & LOG_ROLL_PID_P) {
 		bbBuffer[bufferPos++] = rollP.geti32();
 		bbBuffer[bufferPos++] = rollP.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_ROLL_PID_I) {
+	if (flags & LOG_ROLL_PID_I) {
 		bbBuffer[bufferPos++] = rollI.geti32();
 		bbBuffer[bufferPos++] = rollI.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_ROLL_PID_D) {
+	if (flags & LOG_ROLL_PID_D) {
 		bbBuffer[bufferPos++] = rollD.geti32();
 		bbBuffer[bufferPos++] = rollD.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_ROLL_PID_FF) {
+	if (flags & LOG_ROLL_PID_FF) {
 		bbBuffer[bufferPos++] = rollFF.geti32();
 		bbBuffer[bufferPos++] = rollFF.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_ROLL_PID_S) {
+	if (flags & LOG_ROLL_PID_S) {
 		bbBuffer[bufferPos++] = rollS.geti32();
 		bbBuffer[bufferPos++] = rollS.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_PITCH_PID_P) {
+	if (flags & LOG_PITCH_PID_P) {
 		bbBuffer[bufferPos++] = pitchP.geti32();
 		bbBuffer[bufferPos++] = pitchP.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_PITCH_PID_I) {
+	if (flags & LOG_PITCH_PID_I) {
 		bbBuffer[bufferPos++] = pitchI.geti32();
 		bbBuffer[bufferPos++] = pitchI.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_PITCH_PID_D) {
+	if (flags & LOG_PITCH_PID_D) {
 		bbBuffer[bufferPos++] = pitchD.geti32();
 		bbBuffer[bufferPos++] = pitchD.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_PITCH_PID_FF) {
+	if (flags & LOG_PITCH_PID_FF) {
 		bbBuffer[bufferPos++] = pitchFF.geti32();
 		bbBuffer[bufferPos++] = pitchFF.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_PITCH_PID_S) {
+	if (flags & LOG_PITCH_PID_S) {
 		bbBuffer[bufferPos++] = pitchS.geti32();
 		bbBuffer[bufferPos++] = pitchS.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_YAW_PID_P) {
+	if (flags & LOG_YAW_PID_P) {
 		bbBuffer[bufferPos++] = yawP.geti32();
 		bbBuffer[bufferPos++] = yawP.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_YAW_PID_I) {
+	if (flags & LOG_YAW_PID_I) {
 		bbBuffer[bufferPos++] = yawI.geti32();
 		bbBuffer[bufferPos++] = yawI.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_YAW_PID_D) {
+	if (flags & LOG_YAW_PID_D) {
 		bbBuffer[bufferPos++] = yawD.geti32();
 		bbBuffer[bufferPos++] = yawD.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_YAW_PID_FF) {
+	if (flags & LOG_YAW_PID_FF) {
 		bbBuffer[bufferPos++] = yawFF.geti32();
 		bbBuffer[bufferPos++] = yawFF.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_YAW_PID_S) {
+	if (flags & LOG_YAW_PID_S) {
 		bbBuffer[bufferPos++] = yawS.geti32();
 		bbBuffer[bufferPos++] = yawS.geti32() >> 8;
 	}
-	if (currentBBFlags & LOG_MOTOR_OUTPUTS) {
+	if (flags & LOG_MOTOR_OUTPUTS) {
 		u64 throttles64 = throttles[(u8)MOTOR::RR] | (u64)throttles[(u8)MOTOR::FR] << 12 | (u64)throttles[(u8)MOTOR::RL] << 24 | (u64)throttles[(u8)MOTOR::FL] << 36;
 		bbBuffer[bufferPos++] = throttles64;
 		bbBuffer[bufferPos++] = throttles64 >> 8;
@@ -345,26 +325,26 @@ void __not_in_flash_func(writeSingleFrame)() {
 		bbBuffer[bufferPos++] = throttles64 >> 32;
 		bbBuffer[bufferPos++] = throttles64 >> 40;
 	}
-	if (currentBBFlags & LOG_FRAMETIME) {
+	if (flags & LOG_FRAMETIME) {
 		u16 ft = frametime;
 		frametime = 0;
 		bbBuffer[bufferPos++] = ft;
 		bbBuffer[bufferPos++] = ft >> 8;
 	}
-	if (currentBBFlags & LOG_FLIGHT_MODE) {
+	if (flags & LOG_FLIGHT_MODE) {
 		bbBuffer[bufferPos++] = (u8)flightMode;
 	}
-	if (currentBBFlags & LOG_ALTITUDE) {
+	if (flags & LOG_ALTITUDE) {
 		const u32 height = combinedAltitude.raw >> 12; // 12.4 fixed point, approx. 6cm resolution, 4km altitude
 		bbBuffer[bufferPos++] = height;
 		bbBuffer[bufferPos++] = height >> 8;
 	}
-	if (currentBBFlags & LOG_VVEL) {
+	if (flags & LOG_VVEL) {
 		const i32 vvel = vVel.raw >> 8; // 8.8 fixed point, approx. 4mm/s resolution, +-128m/s max
 		bbBuffer[bufferPos++] = vvel;
 		bbBuffer[bufferPos++] = vvel >> 8;
 	}
-	if (currentBBFlags & LOG_GPS) {
+	if (flags & LOG_GPS) {
 		if (bbFrameNum - newestPvtStartedAt < 46) {
 			u32 pos = (bbFrameNum - newestPvtStartedAt) * 2;
 			bbBuffer[bufferPos++] = currentPvtMsg[pos];
@@ -389,22 +369,22 @@ void __not_in_flash_func(writeSingleFrame)() {
 			bbBuffer[bufferPos++] = 0;
 		}
 	}
-	if (currentBBFlags & LOG_ATT_ROLL) {
+	if (flags & LOG_ATT_ROLL) {
 		i16 r = (roll * 10000).geti32();
 		bbBuffer[bufferPos++] = r;
 		bbBuffer[bufferPos++] = r >> 8;
 	}
-	if (currentBBFlags & LOG_ATT_PITCH) {
+	if (flags & LOG_ATT_PITCH) {
 		i16 p = (pitch * 10000).geti32();
 		bbBuffer[bufferPos++] = p;
 		bbBuffer[bufferPos++] = p >> 8;
 	}
-	if (currentBBFlags & LOG_ATT_YAW) {
+	if (flags & LOG_ATT_YAW) {
 		i16 y = (yaw * 10000).geti32();
 		bbBuffer[bufferPos++] = y;
 		bbBuffer[bufferPos++] = y >> 8;
 	}
-	if (currentBBFlags & LOG_MOTOR_RPM) {
+	if (flags & LOG_MOTOR_RPM) {
 		u64 rpmPacket = condensedRpm[(u8)MOTOR::RR] | condensedRpm[(u8)MOTOR::FR] << 12 | (u64)condensedRpm[(u8)MOTOR::RL] << 24 | (u64)condensedRpm[(u8)MOTOR::FL] << 36;
 		bbBuffer[bufferPos++] = rpmPacket;
 		bbBuffer[bufferPos++] = rpmPacket >> 8;
@@ -413,11 +393,11 @@ void __not_in_flash_func(writeSingleFrame)() {
 		bbBuffer[bufferPos++] = rpmPacket >> 32;
 		bbBuffer[bufferPos++] = rpmPacket >> 40;
 	}
-	if (currentBBFlags & LOG_ACCEL_RAW) {
+	if (flags & LOG_ACCEL_RAW) {
 		memcpy(&bbBuffer[bufferPos], accelDataRaw, 6);
 		bufferPos += 6;
 	}
-	if (currentBBFlags & LOG_ACCEL_FILTERED) {
+	if (flags & LOG_ACCEL_FILTERED) {
 		i16 i = ((fix32)accelDataFiltered[0]).geti32();
 		bbBuffer[bufferPos++] = i;
 		bbBuffer[bufferPos++] = i >> 8;
@@ -428,40 +408,62 @@ void __not_in_flash_func(writeSingleFrame)() {
 		bbBuffer[bufferPos++] = i;
 		bbBuffer[bufferPos++] = i >> 8;
 	}
-	if (currentBBFlags & LOG_VERTICAL_ACCEL) {
+	if (flags & LOG_VERTICAL_ACCEL) {
 		i16 a = (i16)(vAccel.raw >> 9);
 		bbBuffer[bufferPos++] = a;
 		bbBuffer[bufferPos++] = a >> 8;
 	}
-	if (currentBBFlags & LOG_VVEL_SETPOINT) {
+	if (flags & LOG_VVEL_SETPOINT) {
 		i16 v = (i16)(vVelSetpoint.raw >> 4) * ((u32)flightMode >= 2);
 		bbBuffer[bufferPos++] = v;
 		bbBuffer[bufferPos++] = v >> 8;
 	}
-	if (currentBBFlags & LOG_MAG_HEADING) {
+	if (flags & LOG_MAG_HEADING) {
 		i16 h = (i16)(magHeading.raw >> 3);
 		bbBuffer[bufferPos++] = h;
 		bbBuffer[bufferPos++] = h >> 8;
 	}
-	if (currentBBFlags & LOG_COMBINED_HEADING) {
+	if (flags & LOG_COMBINED_HEADING) {
 		int h = combinedHeading.raw >> 3;
 		bbBuffer[bufferPos++] = h;
 		bbBuffer[bufferPos++] = h >> 8;
 	}
+	if (flags & LOG_GYRO_LATENCY) {
+		// in 10 ns steps, saturating at 655 µs
+		u32 l = cyclesToNs(gyroToMotorCycles) / 10;
+		if (l > 0xFFFF) l = 0xFFFF;
+		bbBuffer[bufferPos++] = l;
+		bbBuffer[bufferPos++] = l >> 8;
+	}
+	return bufferPos;
+}
+
+void __not_in_flash_func(writeSingleFrame)() {
+	if (!fsReady || !bbLogging) {
+		return;
+	}
+#if BLACKBOX_STORAGE == LITTLEFS
+	if (blackboxFile.size() > maxFileSize) {
+		endLogging();
+		return;
+	}
+#endif
+	u8 *bbBuffer = (u8 *)malloc(128);
+	size_t bufferPos = encodeBlackboxFrame(bbBuffer, currentBBFlags);
 #if BLACKBOX_STORAGE == LITTLEFS
 	blackboxFile.write(bbBuffer, bufferPos);
 #elif BLACKBOX_STORAGE == SD_BB
 	bbBuffer[0] = bufferPos - 1;
 	bbFrameNum++;
 	if (bbFramePtrBuffer.isEmpty()) {
-		if (!rp2040.fifo.push_nb((u32)bbBuffer)) {
+		if (!rp2040.fifo.push_nb((uintptr_t)bbBuffer)) {
 			bbFramePtrBuffer.push(bbBuffer);
 		}
 	} else if (!bbFramePtrBuffer.isFull()) {
 		bbFramePtrBuffer.push(bbBuffer);
 		for (u32 i = bbFramePtrBuffer.itemCount(); i; i--) {
 			u8 *frame = bbFramePtrBuffer[0];
-			if (rp2040.fifo.push_nb((u32)frame)) {
+			if (rp2040.fifo.push_nb((uintptr_t)frame)) {
 				bbFramePtrBuffer.pop();
 			} else {
 				break;
@@ -469,12 +471,12 @@ void __not_in_flash_func(writeSingleFrame)() {
 		}
 	} else {
 		u8 *frame = bbFramePtrBuffer[0];
-		if (rp2040.fifo.push_nb((u32)frame)) {
+		if (rp2040.fifo.push_nb((uintptr_t)frame)) {
 			bbFramePtrBuffer.pop();
 			bbFramePtrBuffer.push(bbBuffer);
 			for (u32 i = bbFramePtrBuffer.itemCount(); i; i--) {
 				u8 *frame = bbFramePtrBuffer[0];
-				if (rp2040.fifo.push_nb((u32)frame)) {
+				if (rp2040.fifo.push_nb((uintptr_t)frame)) {
 					bbFramePtrBuffer.pop();
 				} else {
 					break;
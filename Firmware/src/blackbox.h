@@ -45,6 +45,7 @@
 #define LOG_VVEL_SETPOINT (1LL << 39) // 2 bytes
 #define LOG_MAG_HEADING (1LL << 40) // 2 bytes
 #define LOG_COMBINED_HEADING (1LL << 41) // 2 bytes
+#define LOG_GYRO_LATENCY (1LL << 42) // 2 bytes
 
 #define LOG_HEAD_MAGIC 0
 #define LOG_HEAD_BB_VERSION 4
@@ -82,6 +83,15 @@ bool clearBlackbox();
 /// @brief Write a single frame to the blackbox file
 void writeSingleFrame();
 
+/**
+ * @brief Encodes the current state into one blackbox frame, used by writeSingleFrame
+ *
+ * @param bbBuffer buffer of at least 128 bytes, the frame starts at index 1 (index 0 is for the length)
+ * @param flags fields to encode (LOG_ macros)
+ * @return size_t end of the frame in bbBuffer
+ */
+size_t encodeBlackboxFrame(u8 *bbBuffer, u64 flags);
+
 /**
  * @brief Print a log file to the configurator using MspFn::BB_FILE_DOWNLOAD
  *
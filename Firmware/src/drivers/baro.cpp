@@ -68,34 +68,23 @@ void initBaro() {
 	regWrite(SPI_BARO, PIN_BARO_CS, 0x08, data, 1, 0); // set MEAS_CFG register
 }
 
-elapsedMillis baroTimer = 0;
+ElapsedLoopMillis baroTimer = 0;
 volatile i32 pressure, baroTemperature;
 volatile bool newBaroData = false;
 void readBaroLoop() {
 	if (baroTimer >= 20) {
-		elapsedMicros taskTimer = 0;
-		tasks[TASK_BAROREAD].runCounter++;
+		TASK_PROBE(TASK_BAROREAD);
 		baroTimer = 0;
 		getRawPressureTemperature(&pressure, &baroTemperature);
 		newBaroData = true;
-		u32 duration = taskTimer;
-		tasks[TASK_BAROREAD].totalDuration += duration;
-		if (duration < tasks[TASK_BAROREAD].minDuration) {
-			tasks[TASK_BAROREAD].minDuration = duration;
-		}
-		if (duration > tasks[TASK_BAROREAD].maxDuration) {
-			tasks[TASK_BAROREAD].maxDuration = duration;
-		}
 	}
 }
 
 f32 lastBaroASL = 0, gpsBaroOffset = 0;
-elapsedMillis baroEvalTimer = 0;
+ElapsedLoopMillis baroEvalTimer = 0;
 void evalBaroLoop() {
 	if (!newBaroData) return;
 	newBaroData = false;
-	tasks[TASK_BAROEVAL].runCounter++;
-	elapsedMicros taskTimer = 0;
 	baroTemp = 201 * .5f - baroTemperature / 7864320.f * 260;
 	f32 pressureScaled = pressure / 7864320.f;
 	f32 temperatureScaled = baroTemperature / 7864320.f;
@@ -108,12 +97,4 @@ void evalBaroLoop() {
 		gpsBaroOffset = baroASL - gpsMotion.alt / 1000.f;
 	baroUpVel = (baroASL - lastBaroASL) * 50;
 	baroEvalTimer = 0;
-	u32 duration = taskTimer;
-	tasks[TASK_BAROEVAL].totalDuration += duration;
-	if (duration < tasks[TASK_BAROEVAL].minDuration) {
-		tasks[TASK_BAROEVAL].minDuration = duration;
-	}
-	if (duration > tasks[TASK_BAROEVAL].maxDuration) {
-		tasks[TASK_BAROEVAL].maxDuration = duration;
-	}
 }
\ No newline at end of file
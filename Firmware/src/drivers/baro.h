@@ -6,6 +6,7 @@ extern f32 baroUpVel;
 extern f32 baroPres;
 extern u8 baroTemp;
 extern fix32 gpsBaroAlt;
+extern volatile bool newBaroData; // set by readBaroLoop on core 1, cleared by evalBaroLoop
 
 /// Initializes the barometer (Goertek SPL06-007)
 void initBaro();
@@ -2,6 +2,7 @@
 
 u32 enableDShot = 1;
 u32 escPioOffset = 0;
+u32 gyroToMotorCycles = 0;
 
 volatile u32 escRpm[4] = {0};
 u8 escErpmFail = 0;
@@ -47,6 +48,14 @@ void sendRaw16Bit(const u16 raw[4]) {
 			pio_sm_exec(ESC_PIO, i, pio_encode_jmp(escPioOffset + 1));
 		pio_sm_put(ESC_PIO, i, ~(raw[i]));
 	}
+	if (gyroEdgePending) {
+		gyroEdgePending = false;
+		const u32 now = cycleCount();
+		gyroToMotorCycles = now - gyroEdgeCycles;
+#if TASK_PROBES
+		recordTaskRun(TASK_GYRO_LATENCY, gyroEdgeCycles, now);
+#endif
+	}
 }
 
 void sendRaw11Bit(const u16 raw[4]) {
@@ -71,8 +80,7 @@ void sendThrottles(const i16 throttles[4]) {
 
 void decodeErpm() {
 	if (!enableDShot) return;
-	tasks[TASK_ESC_RPM].runCounter++;
-	elapsedMicros taskTimer = 0;
+	TASK_PROBE(TASK_ESC_RPM);
 	for (int m = 0; m < 4; m++) {
 		if (pio_sm_is_rx_fifo_empty(ESC_PIO, m)) {
 			escErpmFail |= 1 << m;
@@ -85,40 +93,38 @@ void decodeErpm() {
 		while (!pio_sm_is_rx_fifo_empty(ESC_PIO, m)) {
 			edgeDetectedReturn = pio_sm_get_blocking(ESC_PIO, m);
 		}
-		edgeDetectedReturn = edgeDetectedReturn ^ (edgeDetectedReturn >> 1);
-		u32 rpm = escDecodeLut[edgeDetectedReturn & 0x1F];
-		rpm |= escDecodeLut[(edgeDetectedReturn >> 5) & 0x1F] << 4;
-		rpm |= escDecodeLut[(edgeDetectedReturn >> 10) & 0x1F] << 8;
-		rpm |= escDecodeLut[(edgeDetectedReturn >> 15) & 0x1F] << 12;
-		u32 csum = (rpm >> 8) ^ rpm;
-		csum ^= csum >> 4;
-		csum &= 0xF;
-		if (csum != 0x0F || rpm > 0xFFFF) {
+		decodeErpmFrame(m, edgeDetectedReturn);
+	}
+}
+
+void __not_in_flash_func(decodeErpmFrame)(u8 m, u32 edgeDetectedReturn) {
+	edgeDetectedReturn = edgeDetectedReturn ^ (edgeDetectedReturn >> 1);
+	u32 rpm = escDecodeLut[edgeDetectedReturn & 0x1F];
+	rpm |= escDecodeLut[(edgeDetectedReturn >> 5) & 0x1F] << 4;
+	rpm |= escDecodeLut[(edgeDetectedReturn >> 10) & 0x1F] << 8;
+	rpm |= escDecodeLut[(edgeDetectedReturn >> 15) & 0x1F] << 12;
+	u32 csum = (rpm >> 8) ^ rpm;
+	csum ^= csum >> 4;
+	csum &= 0xF;
+	if (csum != 0x0F || rpm > 0xFFFF) {
+		escErpmFail |= 1 << m;
+		tasks[TASK_ESC_RPM].errorCount++;
+		tasks[TASK_ESC_RPM].lastError = 2;
+		condensedRpm[m] = 0;
+		return;
+	}
+	rpm >>= 4;
+	condensedRpm[m] = rpm;
+	if (rpm == 0xFFF) {
+		escRpm[m] = 0;
+	} else {
+		rpm = (rpm & 0x1FF) << (rpm >> 9); // eeem mmmm mmmm
+		if (!rpm) {
 			escErpmFail |= 1 << m;
-			tasks[TASK_ESC_RPM].errorCount++;
-			tasks[TASK_ESC_RPM].lastError = 2;
-			condensedRpm[m] = 0;
-			continue;
-		}
-		rpm >>= 4;
-		condensedRpm[m] = rpm;
-		if (rpm == 0xFFF) {
-			escRpm[m] = 0;
-		} else {
-			rpm = (rpm & 0x1FF) << (rpm >> 9); // eeem mmmm mmmm
-			if (!rpm) {
-				escErpmFail |= 1 << m;
-				continue;
-			}
-			rpm = (60000000 + 50 * rpm) / rpm;
-			escRpm[m] = rpm / (MOTOR_POLES / 2);
-			escErpmFail &= ~(1 << m);
+			return;
 		}
+		rpm = (60000000 + 50 * rpm) / rpm;
+		escRpm[m] = rpm / (MOTOR_POLES / 2);
+		escErpmFail &= ~(1 << m);
 	}
-	u32 duration = taskTimer;
-	tasks[TASK_ESC_RPM].totalDuration += duration;
-	if (duration > tasks[TASK_ESC_RPM].maxDuration)
-		tasks[TASK_ESC_RPM].maxDuration = duration;
-	if (duration < tasks[TASK_ESC_RPM].minDuration)
-		tasks[TASK_ESC_RPM].minDuration = duration;
-}
\ No newline at end of file
+}
@@ -40,6 +40,7 @@ extern const u32 escDecodeLut[32]; // lookup table for GCR decoding
 extern u8 escErpmFail; // flags for failed RPM decoding
 extern u32 enableDShot; // set to 0 to disable DShot output, e.g. for 4Way
 extern u32 escPioOffset; // offset at which the DShot program is stored
+extern u32 gyroToMotorCycles; // cycles from the INT1 edge to the DShot frame of the last PID loop, see sendRaw16Bit
 
 /// @brief Initializes the ESC communication
 void initESCs();
@@ -65,6 +66,9 @@ void sendRaw11Bit(const u16 raw[4]);
 /**
  * @brief Sends raw values to all four ESCs (useful for special commands)
  *
+ * @details The first frame after a rising edge of the gyro INT1 pin ends the gyro-to-motor latency measurement
+ * (gyroToMotorCycles, TASK_GYRO_LATENCY), which covers the SPI read, the IMU update and the PID loop.
+ *
  * @param raw Array of four raw values, including the telemetry bits and checksum
  */
 void sendRaw16Bit(const u16 raw[4]);
@@ -74,4 +78,12 @@ void sendRaw16Bit(const u16 raw[4]);
  *
  * Stores them in escRpm array and sets or clears the corresponding bit in escErpmFail depending on whether the decoded value is valid (checksum correct)
  */
-void decodeErpm();
\ No newline at end of file
+void decodeErpm();
+
+/**
+ * @brief Decodes one telemetry frame of a motor, used by decodeErpm
+ *
+ * @param m motor index (0-3)
+ * @param edgeDetectedReturn raw value from the RX FIFO of the DShot state machine
+ */
+void decodeErpmFrame(u8 m, u32 edgeDetectedReturn);
\ No newline at end of file
@@ -2,8 +2,39 @@
 
 // driver for the BMI270 IMU https://www.bosch-sensortec.com/media/boschsensortec/downloads/datasheets/bst-bmi270-ds000.pdf
 
-u32 gyroLastState = 0;
-elapsedMicros lastPIDLoop = 0;
+u32 gyroEdgeCycles = 0;
+bool gyroEdgePending = false;
+ElapsedLoopMicros lastPIDLoop = 0;
+volatile bool gyroSampleReady = false;
+fix32 gyroSampleDtUs = GYRO_SENSOR_TIME_US * GYRO_LOOP_TICKS;
+fix32 gyroTickUs = GYRO_SENSOR_TIME_US;
+
+// the FIFO watermark edge starts a DMA burst read of the FIFO, the DMA interrupt parses the frames into the sample queue
+// per transfer: read command, dummy byte, GYRO_FIFO_BURST data bytes
+#define GYRO_DMA_LENGTH (GYRO_FIFO_BURST + 2)
+#define GYRO_TIME_CAL_TICKS 25600 // sensor time ticks (1 s) per measurement of gyroTickUs
+static const u8 gyroDmaTx[GYRO_DMA_LENGTH] = {0x80 | (u8)GyroReg::FIFO_DATA};
+static u8 gyroDmaRx[GYRO_DMA_LENGTH] __attribute__((aligned(4)));
+static volatile u32 gyroEdgeRaw = 0; // raw SysTick value at the last watermark edge
+static volatile bool gyroReadFromEdge = false; // whether the next sample was triggered by a watermark edge or by the timeout
+static u32 gyroBurstCount = 0; // FIFO reads in a row, see GYRO_FIFO_MAX_BURSTS
+static int gyroDmaTxChan = -1, gyroDmaRxChan = -1;
+
+/// @brief PID loop sample with the sensor time of its last gyro frame
+typedef struct gyroSample {
+	i16 data[6]; // accel x, y, z, gyro x, y, z
+	u32 time; // sensor time ticks, continued beyond the 24 bits of the sensor
+} GyroSample;
+static GyroSample gyroQueue[GYRO_QUEUE_SIZE];
+static volatile u32 gyroQueueHead = 0, gyroQueueTail = 0; // free running, written by the DMA interrupt and by gyroGetData
+static GyroSample gyroLastSample = {{0, 0, 2048, 0, 0, 0}, 0}; // last sample of gyroGetData, repeated if the queue is empty
+static u32 gyroFifoTime = 0; // sensor time of the last gyro frame
+static i16 gyroFifoAccel[3] = {0, 0, 2048}; // last accel frame, the accel runs at ACCEL_RATE
+static u32 gyroTimeCalUs = 0, gyroTimeCalTicks = 0; // start of the running gyroTickUs measurement
+#if GYRO_OVERSAMPLING > 1
+static u8 gyroOversamplePhase = 0; // gyro frames since the last PID loop sample
+static i16 gyroHistory[3][3] = {0}; // last three gyro samples per axis at the sensor rate, [0] is the newest
+#endif
 
 u32 gyroCalibratedCycles = 0;
 i32 gyroCalibrationOffset[3] = {0};
@@ -14,57 +45,243 @@ u16 accelCalibrationCycles = 0;
 
 extern const u8 bmi270_config_file[8192];
 
+/// @brief starts a DMA burst read of the FIFO, the bus is already claimed
+static void __not_in_flash_func(gyroStartBurst)() {
+	gpio_put(PIN_GYRO_CS, 0);
+	dma_channel_set_read_addr(gyroDmaTxChan, gyroDmaTx, false);
+	dma_channel_set_write_addr(gyroDmaRxChan, gyroDmaRx, false);
+	dma_start_channel_mask(1u << gyroDmaTxChan | 1u << gyroDmaRxChan);
+}
+
+/// @brief starts the DMA read of the FIFO, interrupts must be disabled
+static void __not_in_flash_func(gyroStartRead)() {
+	if (!spiTryClaim(gyroStartBurst)) return; // a transfer is running, spiRelease starts the burst
+	gyroStartBurst();
+}
+
+static void __not_in_flash_func(gyroEdgeIrq)(uint gpio, u32 events) {
+	if (gpio != PIN_GYRO_INT1) return;
+	gyroEdgeRaw = cycleCountRaw();
+	gyroReadFromEdge = true;
+	gyroStartRead();
+}
+
+#if GYRO_OVERSAMPLING > 1
+/**
+ * @brief runs the decimation filter over a new gyro frame
+ *
+ * @details [1 3 3 1] / 8 over the last four gyro samples, evaluated only for the samples that go to the PID loop.
+ * @param gyro gyro x, y, z, replaced by the filtered values
+ * @return true if the sample goes to the PID loop
+ */
+static bool __not_in_flash_func(gyroDecimate)(i16 *gyro) {
+	const bool output = ++gyroOversamplePhase == GYRO_OVERSAMPLING;
+	if (output) gyroOversamplePhase = 0;
+	for (int ax = 0; ax < 3; ax++) {
+		i16 *h = gyroHistory[ax];
+		const i16 x = gyro[ax];
+		if (output) gyro[ax] = (x + 3 * (h[0] + h[1]) + h[2] + 4) >> 3;
+		h[2] = h[1];
+		h[1] = h[0];
+		h[0] = x;
+	}
+	return output;
+}
+#endif
+
+/// @brief a gyro frame of the FIFO, queued as a PID loop sample after the decimation
+static void __not_in_flash_func(gyroFifoGyro)(const u8 *frame) {
+	i16 gyro[3];
+	memcpy(gyro, frame, sizeof(gyro));
+	gyroFifoTime += GYRO_FRAME_TICKS;
+#if GYRO_OVERSAMPLING > 1
+	if (!gyroDecimate(gyro)) return;
+#endif
+	if (gyroQueueHead - gyroQueueTail >= GYRO_QUEUE_SIZE) {
+		// the PID loop fell behind by more than the queue, the oldest sample is dropped
+		gyroQueueTail++;
+		tasks[TASK_GYROREAD].errorCount++;
+		tasks[TASK_GYROREAD].lastError = 1;
+	}
+	GyroSample &s = gyroQueue[gyroQueueHead % GYRO_QUEUE_SIZE];
+	memcpy(s.data, gyroFifoAccel, sizeof(gyroFifoAccel));
+	memcpy(s.data + 3, gyro, sizeof(gyro));
+	s.time = gyroFifoTime;
+	gyroQueueHead++;
+}
+
+/// @brief a sensor time frame: corrects the time of the gyro frames and measures gyroTickUs against the system timer
+static void __not_in_flash_func(gyroFifoTimeFrame)(const u8 *frame) {
+	const u32 t = frame[0] | frame[1] << 8 | frame[2] << 16;
+	gyroFifoTime += (i32)((t - gyroFifoTime) << 8) >> 8; // the sensor time has 24 bits
+	const u32 now = micros();
+	const u32 ticks = gyroFifoTime - gyroTimeCalTicks;
+	if (!gyroTimeCalUs || ticks > 4 * GYRO_TIME_CAL_TICKS) {
+		gyroTimeCalUs = now;
+		gyroTimeCalTicks = gyroFifoTime;
+	} else if (ticks >= GYRO_TIME_CAL_TICKS) {
+		const fix32 tick = fix32().setRaw(((u64)(now - gyroTimeCalUs) << 16) / ticks);
+		// more than 5 % off is not the oscillator of the sensor, but e.g. a read that was held back
+		if (tick > GYRO_SENSOR_TIME_US * 0.95f && tick < GYRO_SENSOR_TIME_US * 1.05f) gyroTickUs = tick;
+		gyroTimeCalUs = now;
+		gyroTimeCalTicks = gyroFifoTime;
+	}
+}
+
+/**
+ * @brief parses the frames of one FIFO burst
+ *
+ * @details A frame that is cut off at the end of the burst is sent again by the sensor in the next read.
+ * @param data GYRO_FIFO_BURST bytes from FIFO_DATA
+ * @return true if the end of the FIFO was reached
+ */
+static bool __not_in_flash_func(gyroParseFifo)(const u8 *data) {
+	u32 i = 0;
+	while (i < GYRO_FIFO_BURST) {
+		const u8 header = data[i] & 0xFC;
+		u32 length;
+		switch (header) {
+		case (u8)GyroFifoHeader::ACCEL:
+		case (u8)GyroFifoHeader::GYRO:
+			length = 7;
+			break;
+		case (u8)GyroFifoHeader::GYRO_ACCEL:
+			length = 13;
+			break;
+		case (u8)GyroFifoHeader::SKIP:
+			length = 2;
+			break;
+		case (u8)GyroFifoHeader::TIME:
+			length = 4;
+			break;
+		case (u8)GyroFifoHeader::CONFIG:
+			length = 5;
+			break;
+		default:
+			return true; // over-read, only follows after the end of the FIFO
+		}
+		if (i + length > GYRO_FIFO_BURST) return false;
+		const u8 *frame = &data[i + 1];
+		switch (header) {
+		case (u8)GyroFifoHeader::ACCEL:
+			memcpy(gyroFifoAccel, frame, sizeof(gyroFifoAccel));
+			break;
+		case (u8)GyroFifoHeader::GYRO:
+			gyroFifoGyro(frame);
+			break;
+		case (u8)GyroFifoHeader::GYRO_ACCEL:
+			memcpy(gyroFifoAccel, frame + 6, sizeof(gyroFifoAccel));
+			gyroFifoGyro(frame);
+			break;
+		case (u8)GyroFifoHeader::SKIP:
+			tasks[TASK_GYROREAD].errorCount++;
+			tasks[TASK_GYROREAD].lastError = 2;
+			break;
+		case (u8)GyroFifoHeader::TIME:
+			gyroFifoTimeFrame(frame);
+			return true; // the sensor time frame follows the last frame
+		}
+		i += length;
+	}
+	return false;
+}
+
+static void __not_in_flash_func(gyroDmaIrq)() {
+	if (!(dma_hw->ints1 & (1u << gyroDmaRxChan))) return;
+	dma_hw->ints1 = 1u << gyroDmaRxChan;
+	gpio_put(PIN_GYRO_CS, 1); // the RX channel finishes after the TX channel
+	if (!gyroParseFifo(&gyroDmaRx[2]) && ++gyroBurstCount < GYRO_FIFO_MAX_BURSTS) {
+		// there is more in the FIFO, e.g. after spi0 was blocked, the next burst keeps the bus
+		gyroStartBurst();
+		return;
+	}
+	gyroBurstCount = 0;
+	gyroSampleReady = true;
+	spiRelease(SPI_GYRO);
+}
+
+void gyroStartAcquisition() {
+	gyroDmaTxChan = dma_claim_unused_channel(true);
+	gyroDmaRxChan = dma_claim_unused_channel(true);
+	dma_channel_config c = dma_channel_get_default_config(gyroDmaTxChan);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, true);
+	channel_config_set_write_increment(&c, false);
+	channel_config_set_dreq(&c, spi_get_dreq(SPI_GYRO, true));
+	dma_channel_configure(gyroDmaTxChan, &c, &spi_get_hw(SPI_GYRO)->dr, gyroDmaTx, GYRO_DMA_LENGTH, false);
+	c = dma_channel_get_default_config(gyroDmaRxChan);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, true);
+	channel_config_set_dreq(&c, spi_get_dreq(SPI_GYRO, false));
+	dma_channel_configure(gyroDmaRxChan, &c, gyroDmaRx, &spi_get_hw(SPI_GYRO)->dr, GYRO_DMA_LENGTH, false);
+	dma_channel_set_irq1_enabled(gyroDmaRxChan, true);
+	irq_set_exclusive_handler(DMA_IRQ_1, gyroDmaIrq);
+	irq_set_enabled(DMA_IRQ_1, true);
+	gpio_set_irq_enabled_with_callback(PIN_GYRO_INT1, GPIO_IRQ_EDGE_RISE, true, gyroEdgeIrq);
+}
+
 void gyroLoop() {
-	u8 gpioState = gpio_get(PIN_GYRO_INT1);
-	// actual interrupts might interrupt the code at a bad time, so we just poll the pin
-	// latched interrupts have the disadvantage of having to read multiple registers, thus taking longer
-	if (gpioState != gyroLastState || lastPIDLoop > 400) {
-		gyroLastState = gpioState;
-		if (gpioState == 1 || lastPIDLoop > 400) {
-			lastPIDLoop = 0;
-			pidLoop();
-			if (armingDisableFlags & 0x40) {
-				if (gyroDataRaw[0] < CALIBRATION_TOLERANCE && gyroDataRaw[0] > -CALIBRATION_TOLERANCE && gyroDataRaw[1] < CALIBRATION_TOLERANCE && gyroDataRaw[1] > -CALIBRATION_TOLERANCE && gyroDataRaw[2] < CALIBRATION_TOLERANCE && gyroDataRaw[2] > -CALIBRATION_TOLERANCE && (gyroDataRaw[0] != -1 || gyroDataRaw[1] != -1 || gyroDataRaw[2] != -1)) {
-					// ignore -1 (0xFFFF), as this speaks for a communication error
-					gyroCalibratedCycles++;
-					if (gyroCalibratedCycles >= QUIET_SAMPLES) {
-						gyroCalibrationOffsetTemp[0] += gyroDataRaw[0];
-						gyroCalibrationOffsetTemp[1] += gyroDataRaw[1];
-						gyroCalibrationOffsetTemp[2] += gyroDataRaw[2];
-					}
-					if (gyroCalibratedCycles == CALIBRATION_SAMPLES + QUIET_SAMPLES) {
-						armingDisableFlags &= 0xFFFFFFBF;
-						gyroCalibrationOffset[0] = (gyroCalibrationOffsetTemp[0] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
-						gyroCalibrationOffset[1] = (gyroCalibrationOffsetTemp[1] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
-						gyroCalibrationOffset[2] = (gyroCalibrationOffsetTemp[2] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
-					}
-				} else {
-					gyroCalibrationOffsetTemp[0] = 0;
-					gyroCalibrationOffsetTemp[1] = 0;
-					gyroCalibrationOffsetTemp[2] = 0;
-					gyroCalibratedCycles = 0;
-				}
-				if (accelCalibrationCycles) {
-					if (accelCalibrationCycles == CALIBRATION_SAMPLES + QUIET_SAMPLES) {
-						accelCalibrationOffset[0] = 0;
-						accelCalibrationOffset[1] = 0;
-						accelCalibrationOffset[2] = 0;
-						accelCalibrationOffsetTemp[0] = 0;
-						accelCalibrationOffsetTemp[1] = 0;
-						accelCalibrationOffsetTemp[2] = 0;
-					}
-					accelCalibrationCycles--;
-					if (accelCalibrationCycles < CALIBRATION_SAMPLES) {
-						accelCalibrationOffsetTemp[0] += accelDataRaw[0];
-						accelCalibrationOffsetTemp[1] += accelDataRaw[1];
-						accelCalibrationOffsetTemp[2] += accelDataRaw[2] - 2048;
-						if (accelCalibrationCycles == 0) {
-							accelCalibrationOffset[0] = (accelCalibrationOffsetTemp[0] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
-							accelCalibrationOffset[1] = (accelCalibrationOffsetTemp[1] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
-							accelCalibrationOffset[2] = (accelCalibrationOffsetTemp[2] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
-							accelCalDone = 1;
-						}
-					}
+	u32 irq = save_and_disable_interrupts();
+	const bool fromEdge = gyroReadFromEdge, ready = gyroSampleReady;
+	gyroReadFromEdge = false;
+	restore_interrupts(irq);
+	if (!fromEdge && !ready) {
+		if (lastPIDLoop <= 400) return;
+		// no watermark edge for too long, read whatever the FIFO has
+		irq = save_and_disable_interrupts();
+		gyroStartRead();
+		restore_interrupts(irq);
+	}
+	lastPIDLoop = 0;
+	pidPrepare(); // overlaps with the DMA transfer
+	while (!gyroSampleReady) // a deferred read may be started by core 0, but its DMA interrupt still fires here
+		tight_loop_contents();
+	gyroSampleReady = false;
+	// the gyro-to-motor latency is only measured for real watermark edges, not for the timeout
+	gyroEdgePending = fromEdge;
+	if (fromEdge) gyroEdgeCycles = cycleCountFromRaw(gyroEdgeRaw);
+	pidLoop();
+	if (armingDisableFlags & 0x40) {
+		if (gyroDataRaw[0] < CALIBRATION_TOLERANCE && gyroDataRaw[0] > -CALIBRATION_TOLERANCE && gyroDataRaw[1] < CALIBRATION_TOLERANCE && gyroDataRaw[1] > -CALIBRATION_TOLERANCE && gyroDataRaw[2] < CALIBRATION_TOLERANCE && gyroDataRaw[2] > -CALIBRATION_TOLERANCE && (gyroDataRaw[0] != -1 || gyroDataRaw[1] != -1 || gyroDataRaw[2] != -1)) {
+			// ignore -1 (0xFFFF), as this speaks for a communication error
+			gyroCalibratedCycles++;
+			if (gyroCalibratedCycles >= QUIET_SAMPLES) {
+				gyroCalibrationOffsetTemp[0] += gyroDataRaw[0];
+				gyroCalibrationOffsetTemp[1] += gyroDataRaw[1];
+				gyroCalibrationOffsetTemp[2] += gyroDataRaw[2];
+			}
+			if (gyroCalibratedCycles == CALIBRATION_SAMPLES + QUIET_SAMPLES) {
+				armingDisableFlags &= 0xFFFFFFBF;
+				gyroCalibrationOffset[0] = (gyroCalibrationOffsetTemp[0] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
+				gyroCalibrationOffset[1] = (gyroCalibrationOffsetTemp[1] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
+				gyroCalibrationOffset[2] = (gyroCalibrationOffsetTemp[2] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
+			}
+		} else {
+			gyroCalibrationOffsetTemp[0] = 0;
+			gyroCalibrationOffsetTemp[1] = 0;
+			gyroCalibrationOffsetTemp[2] = 0;
+			gyroCalibratedCycles = 0;
+		}
+		if (accelCalibrationCycles) {
+			if (accelCalibrationCycles == CALIBRATION_SAMPLES + QUIET_SAMPLES) {
+				accelCalibrationOffset[0] = 0;
+				accelCalibrationOffset[1] = 0;
+				accelCalibrationOffset[2] = 0;
+				accelCalibrationOffsetTemp[0] = 0;
+				accelCalibrationOffsetTemp[1] = 0;
+				accelCalibrationOffsetTemp[2] = 0;
+			}
+			accelCalibrationCycles--;
+			if (accelCalibrationCycles < CALIBRATION_SAMPLES) {
+				accelCalibrationOffsetTemp[0] += accelDataRaw[0];
+				accelCalibrationOffsetTemp[1] += accelDataRaw[1];
+				accelCalibrationOffsetTemp[2] += accelDataRaw[2] - 2048;
+				if (accelCalibrationCycles == 0) {
+					accelCalibrationOffset[0] = (accelCalibrationOffsetTemp[0] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
+					accelCalibrationOffset[1] = (accelCalibrationOffsetTemp[1] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
+					accelCalibrationOffset[2] = (accelCalibrationOffsetTemp[2] + CALIBRATION_SAMPLES / 2) / CALIBRATION_SAMPLES;
+					accelCalDone = 1;
 				}
 			}
 		}
@@ -117,13 +334,13 @@ int gyroInit() {
 	data = 0b1110; // temp, accel and gyro enabled
 	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::PWR_CTRL, &data, 1, 500);
 	// ACC_CONF: acc_filter_perf (7) | acc_bwp (6...4) | acc_odr (3...0)
-	data = 1 << 7 | 0x02 << 4 | 0x0C; // performance optimized, no averaging, 1600Hz
+	data = 1 << 7 | 0x02 << 4 | (ACCEL_RATE == 800 ? 0x0B : ACCEL_RATE == 400 ? 0x0A : 0x09); // performance optimized, no averaging, ACCEL_RATE
 	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::ACC_CONF, &data, 1, 500);
 	// ACC_RANGE: acc_range (1...0)
 	data = 0x03; // +/- 16g
 	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::ACC_RANGE, &data, 1, 500);
 	// GYR_CONF: gyr_filter_perf (7) | gyr_noise_perf (6) | gyr_bwp (5...4) | gyr_odr (3...0)
-	data = 1 << 7 | 1 << 6 | 0x00 << 4 | 0x0D; // performance optimized, 3200Hz
+	data = 1 << 7 | 1 << 6 | 0x00 << 4 | (GYRO_OVERSAMPLING == 2 ? 0x0E : 0x0D); // performance optimized, 6400Hz or 3200Hz
 	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::GYR_CONF, &data, 1, 500);
 	// GYR_RANGE: ois_range (3) | gyr_range (2...0)
 	data = 0x00; // +/- 2000dps
@@ -131,8 +348,23 @@ int gyroInit() {
 	data = 0x02;
 	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::PWR_CONF, &data, 1, 500);
 
+	// FIFO_DOWNS: acc_fifo_filt_data (7) | acc_fifo_downs (6...4) | gyr_fifo_filt_data (3) | gyr_fifo_downs (2...0)
+	data = 1 << 7 | 1 << 3; // filtered data at the configured rates
+	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::FIFO_DOWNS, &data, 1, 500);
+	// FIFO_WTM: watermark in bytes, reached after GYRO_OVERSAMPLING gyro frames, with or without accel
+	u8 wtm[2] = {GYRO_OVERSAMPLING * 7, 0};
+	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::FIFO_WTM_0, wtm, 2, 500);
+	// FIFO_CONFIG_0: fifo_time_en (1) | fifo_stop_on_full (0)
+	data = 1 << 1; // sensor time frame after the last frame, overwrite the oldest frames when full
+	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::FIFO_CONFIG_0, &data, 1, 500);
+	// FIFO_CONFIG_1: fifo_gyr_en (7) | fifo_acc_en (6) | fifo_aux_en (5) | fifo_header_en (4) | fifo_tag_int1_en (3...2) | fifo_tag_int2_en (1...0)
+	data = 1 << 7 | 1 << 6 | 1 << 4; // gyro and accel frames with headers
+	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::FIFO_CONFIG_1, &data, 1, 500);
+	data = 0xB0; // fifo_flush
+	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::CMD, &data, 1, 500);
+
 	// INT_MAP_DATA: err_int2, drdy_int2, fwm_int2, ffull_int2, err_int1, drdy_int1, fwm_int1, ffull_int1
-	data = 0b10000100;
+	data = 0b10000010;
 	regWrite(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::INT_MAP_DATA, &data, 1, 500);
 	// INT1_IO_CTRL: input_en (4), output_en (3), output_driver (2), output_lvl (1)
 	data = 0b1010;
@@ -149,9 +381,20 @@ int gyroInit() {
 }
 
 u32 gyroUpdateFlag = 0;
-// read all 6 axes of the BMI270
-void gyroGetData(i16 *buf) {
-	regRead(SPI_GYRO, PIN_GYRO_CS, (u8)GyroReg::ACC_X_LSB, (u8 *)buf, 12);
+void __not_in_flash_func(gyroGetData)(i16 *buf) {
+	u32 irq = save_and_disable_interrupts();
+	u32 ticks = 0;
+	if (gyroQueueTail != gyroQueueHead) {
+		const GyroSample &s = gyroQueue[gyroQueueTail % GYRO_QUEUE_SIZE];
+		ticks = s.time - gyroLastSample.time;
+		gyroLastSample = s;
+		gyroQueueTail++;
+	}
+	restore_interrupts(irq);
+	// the first sample and the one after a resynchronisation have no sensible predecessor
+	if (ticks > 4 * GYRO_LOOP_TICKS) ticks = GYRO_LOOP_TICKS;
+	gyroSampleDtUs = gyroTickUs * (i32)ticks;
+	memcpy(buf, gyroLastSample.data, 12);
 	buf[0] -= accelCalibrationOffset[0];
 	buf[1] -= accelCalibrationOffset[1];
 	buf[2] -= accelCalibrationOffset[2];
@@ -161,6 +404,10 @@ void gyroGetData(i16 *buf) {
 	gyroUpdateFlag = 0xFFFFFFFF;
 }
 
+u32 gyroSamplesQueued() {
+	return gyroQueueHead - gyroQueueTail;
+}
+
 // config file needs to be uploaded to the BMI270 before it can be used
 const u8 bmi270_config_file[8192] PROGMEM = {
 	0xc8, 0x2e, 0x00, 0x2e, 0x80, 0x2e, 0x3d, 0xb1, 0xc8, 0x2e, 0x00, 0x2e, 0x80, 0x2e, 0x91, 0x03, 0x80, 0x2e, 0xbc,
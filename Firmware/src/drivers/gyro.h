@@ -1,5 +1,6 @@
 #pragma once
 
+#include "utils/fixedPointInt.h"
 #include <Arduino.h>
 
 // a total of 2000 good samples are required, the first 1000 are ignored
@@ -7,6 +8,29 @@
 #define QUIET_SAMPLES 1000
 #define CALIBRATION_TOLERANCE 64 // (4deg/s)
 
+/**
+ * @brief gyro samples per PID loop, 1 (gyro at 3200 Hz) or 2 (gyro at 6400 Hz)
+ * @details With 2, the FIFO holds two gyro frames per PID loop, and every second one goes to the PID loop after a
+ * [1 3 3 1] / 8 decimation filter (zeros at 3200 Hz, -9 dB at 1600 Hz, -15 dB at 2 kHz), so that motor noise between 1.6
+ * and 3.2 kHz no longer folds into the loop at full strength. The accelerometer keeps its own rate.
+ */
+#define GYRO_OVERSAMPLING 2
+static_assert(GYRO_OVERSAMPLING == 1 || GYRO_OVERSAMPLING == 2, "the BMI270 gyro runs at up to 6400 Hz");
+
+/**
+ * @brief accelerometer data rate, also the rate of the accel fusion of the attitude estimation (200, 400 or 800 Hz)
+ * @details The fusion step is spread over ACCEL_FUSION_PHASES PID loops, so it has to run at most every third loop.
+ */
+#define ACCEL_RATE 800
+static_assert(ACCEL_RATE == 800 || ACCEL_RATE == 400 || ACCEL_RATE == 200, "BMI270 accel data rate up to 800 Hz");
+
+#define GYRO_SENSOR_TIME_US 39.0625f // one tick of SENSOR_TIME and of the FIFO sensor time frames
+#define GYRO_LOOP_TICKS 8 // sensor time between two PID loop samples (3200 Hz)
+#define GYRO_FRAME_TICKS (GYRO_LOOP_TICKS / GYRO_OVERSAMPLING) // sensor time between two gyro frames in the FIFO
+#define GYRO_FIFO_BURST 32 // data bytes per FIFO read: the frames of one PID loop incl. accel, the sensor time frame and a spare frame
+#define GYRO_FIFO_MAX_BURSTS 8 // FIFO reads in a row to drain a backlog, the rest waits for the next watermark edge
+#define GYRO_QUEUE_SIZE 8 // PID loop samples that can wait for the PID loop, power of 2
+
 enum class GyroReg : u8 {
 	CHIP_ID = 0x00,
 	ERROR = 0x02,
@@ -32,12 +56,20 @@ enum class GyroReg : u8 {
 	INTERNAL_STATUS = 0x21,
 	TEMP_LSB = 0x22,
 	TEMP_MSB,
+	FIFO_LENGTH_0 = 0x24,
+	FIFO_LENGTH_1,
+	FIFO_DATA = 0x26,
 	FEAT_PAGE = 0x2F,
 	FEATURES = 0x30,
 	ACC_CONF = 0x40,
 	ACC_RANGE = 0x41,
 	GYR_CONF = 0x42,
 	GYR_RANGE = 0x43,
+	FIFO_DOWNS = 0x45,
+	FIFO_WTM_0 = 0x46,
+	FIFO_WTM_1,
+	FIFO_CONFIG_0 = 0x48,
+	FIFO_CONFIG_1,
 	SATURATION = 0x4A,
 	INT1_IO_CTRL = 0x53,
 	INT2_IO_CTRL = 0x54,
@@ -64,12 +96,28 @@ enum class GyroReg : u8 {
 	CMD = 0x7E,
 };
 
+/// @brief frame headers of the FIFO in header mode, the lower 2 bits are interrupt tags
+enum class GyroFifoHeader : u8 {
+	ACCEL = 0x84, // 6 bytes accel
+	GYRO = 0x88, // 6 bytes gyro
+	GYRO_ACCEL = 0x8C, // 6 bytes gyro, then 6 bytes accel
+	SKIP = 0x40, // 1 byte: number of frames that were lost to an overflow
+	TIME = 0x44, // 3 bytes: sensor time of the last frame, after the last frame when reading beyond the fill level
+	CONFIG = 0x48, // 4 bytes: the FIFO configuration changed
+	OVER_READ = 0x80, // read beyond the fill level
+};
+
 /**
  * @brief provides flags for tasks that depend on the gyro data
  *
  * @details gyro data, and by extension the PID loop, is the most time-sensitive task. it gets priority, and once the data is read, the flag is set to FFFFFFFF so that other tasks know it's safe to run without impacting the gyro data or PID loop.
  */
 extern u32 gyroUpdateFlag;
+extern u32 gyroEdgeCycles; // cycle count (core 1) of the last rising edge of INT1
+extern volatile bool gyroSampleReady; // set by the DMA interrupt once a FIFO read finished and its samples are queued, cleared by gyroLoop
+extern fix32 gyroSampleDtUs; // time between the last two samples of gyroGetData from the sensor time (0 if the sample was repeated)
+extern fix32 gyroTickUs; // length of a sensor time tick, measured against the system timer
+extern bool gyroEdgePending; // set on a rising edge of INT1, cleared once the resulting DShot frame went out
 extern u16 accelCalibrationCycles; /// counts down the cycles for the accelerometer calibration, calibration is done if the value is 0
 extern i32 accelCalibrationOffset[3]; /// offset that gets subtracted from the accelerometer values
 
@@ -78,13 +126,35 @@ extern i32 accelCalibrationOffset[3]; /// offset that gets subtracted from the a
 int gyroInit();
 
 /**
- * @brief reads the gyro data
+ * @brief starts the interrupt driven acquisition, needs to be called on core 1 after gyroInit
  *
- * @details also subtracts offsets and sets the gyroUpdateFlag
+ * @details INT1 is the FIFO watermark (GYRO_OVERSAMPLING gyro frames). Its rising edge starts a DMA burst read of the
+ * FIFO (gpio interrupt), the end of the transfer (DMA_IRQ_1) parses the frames, decimates the gyro axes and queues the
+ * PID loop samples with their sensor time. If the burst did not reach the end of the FIFO (e.g. after spi0 was blocked
+ * for a while), the next burst follows right away, so that a stall of core 1 does not drop samples. spi0 is shared with
+ * the OSD and the baro through spiAcquire.
+ */
+void gyroStartAcquisition();
+
+/**
+ * @brief takes the oldest sample from the queue
+ *
+ * @details also subtracts offsets, sets gyroSampleDtUs and the gyroUpdateFlag. Repeats the last sample if the queue is
+ * empty (timeout read).
  *
- * @param buf buffer to store the data in
+ * @param buf buffer to store the data in (accel x, y, z, gyro x, y, z)
  */
 void gyroGetData(i16 *buf);
 
-/// @brief checks for new gyro data, sets off the read and PID tasks
+/// @brief number of samples that wait for gyroGetData, more than 1 after a stall
+u32 gyroSamplesQueued();
+
+/**
+ * @brief runs the PID loop for a new sample, or reads the gyro on its own if there was no watermark edge for 400 µs
+ *
+ * @details Starts as soon as the watermark edge requested the DMA read: pidPrepare runs while the transfer is in flight, pidLoop once it finished.
+ * If spi0 was claimed by a blocking transfer of either core, the read starts when that transfer releases the bus, the wait covers both.
+ * Samples that queued up in the meantime are processed by pidLoop. TASK_GYROREAD error 1: the queue was full and the
+ * oldest sample was dropped, error 2: the FIFO overflowed.
+ */
 void gyroLoop();
\ No newline at end of file
@@ -3,7 +3,7 @@
 // on drone: x = right, y = backward, z = down
 
 u32 magState = 0;
-elapsedMicros magTimer;
+ElapsedLoopMicros magTimer;
 u8 magBuffer[6] = {0};
 i32 magData[3] = {0};
 
@@ -88,7 +88,6 @@ float cofactor(float matrix[4][4], i32 row, i32 col) {
 }
 
 void magLoop() {
-	elapsedMicros taskTimer = 0;
 	switch (magState) {
 	case MAG_NOT_INIT: // not initialized
 	case MAG_INIT:
@@ -241,11 +240,4 @@ void magLoop() {
 		sendMsp(lastMspSerial, MspMsgType::REQUEST, MspFn::IND_MESSAGE, lastMspVersion, (char *)calString, strlen(calString));
 	} break;
 	}
-	u32 duration = taskTimer;
-	tasks[TASK_MAGNETOMETER].runCounter++;
-	tasks[TASK_MAGNETOMETER].totalDuration += duration;
-	if (duration < tasks[TASK_MAGNETOMETER].minDuration)
-		tasks[TASK_MAGNETOMETER].minDuration = duration;
-	if (duration > tasks[TASK_MAGNETOMETER].maxDuration)
-		tasks[TASK_MAGNETOMETER].maxDuration = duration;
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 u8 osdReady = false;
 
-elapsedMillis osdTimer = 0;
+ElapsedLoopMillis osdTimer = 0;
 
 u8 drawIterator = 0;
 
@@ -81,8 +81,7 @@ void drawElem(u8 elem) {
 
 void osdLoop() {
 	if (osdReady) {
-		elapsedMicros taskTimer = 0;
-		tasks[TASK_OSD].runCounter++;
+		TASK_PROBE(TASK_OSD);
 		// cycle through all drawn elements, and update one per gyro cycle
 		u8 drawIteratorStart = drawIterator;
 		while (1) {
@@ -97,14 +96,6 @@ void osdLoop() {
 			if (drawIterator == drawIteratorStart)
 				break;
 		}
-		u32 duration = taskTimer;
-		tasks[TASK_OSD].totalDuration += duration;
-		if (duration < tasks[TASK_OSD].minDuration) {
-			tasks[TASK_OSD].minDuration = duration;
-		}
-		if (duration > tasks[TASK_OSD].maxDuration) {
-			tasks[TASK_OSD].maxDuration = duration;
-		}
 	}
 	if (osdTimer > 1000 && osdReady != 1) {
 		// gyro likely ready, check registers
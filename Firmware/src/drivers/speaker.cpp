@@ -1,6 +1,6 @@
 #include "global.h"
 
-elapsedMillis soundStart;
+ElapsedLoopMillis soundStart;
 u16 soundDuration = 0;
 u8 soundType = 0; // 0 = stationary, 1 = sweep, 2 = rtttl
 u16 sweepStartFrequency = 0;
@@ -167,8 +167,6 @@ void speakerLoop() {
 		return;
 	}
 
-	elapsedMicros taskTimer = 0;
-	tasks[TASK_SPEAKER].runCounter++;
 	if (!beeperOn && ((ELRS->channels[9] > 1500 && ELRS->isLinkUp) || (ELRS->sinceLastRCMessage > 240000000 && ELRS->rcMsgCount > 50))) {
 		beeperOn = true;
 		makeSweepSound(1000, 5000, 65535, 600, 0);
@@ -236,14 +234,6 @@ void speakerLoop() {
 			}
 		}
 	}
-	u32 duration = taskTimer;
-	tasks[TASK_SPEAKER].totalDuration += duration;
-	if (duration < tasks[TASK_SPEAKER].minDuration) {
-		tasks[TASK_SPEAKER].minDuration = duration;
-	}
-	if (duration > tasks[TASK_SPEAKER].maxDuration) {
-		tasks[TASK_SPEAKER].maxDuration = duration;
-	}
 }
 
 bool playWav(const char *filename) {
@@ -1,17 +1,60 @@
 #include "global.h"
 
+// spi0 is shared between the DMA reads of the gyro (started from interrupts on core 1) and the blocking transfers of both
+// cores (e.g. the OSD font upload from MSP on core 0), so the claim is guarded by a hardware spinlock
+static spin_lock_t *spiLock = nullptr;
+static volatile bool spiBusy = false;
+static void (*volatile spiDeferred)() = nullptr;
+
+bool __not_in_flash_func(spiTryClaim)(void (*start)()) {
+	const u32 irq = spin_lock_blocking(spiLock);
+	const bool claimed = !spiBusy;
+	if (claimed)
+		spiBusy = true;
+	else
+		spiDeferred = start;
+	spin_unlock(spiLock, irq);
+	return claimed;
+}
+
+void __not_in_flash_func(spiAcquire)(spi_inst_t *spi) {
+	if (spi != SPI_GYRO) return;
+	while (true) {
+		const u32 irq = spin_lock_blocking(spiLock);
+		if (!spiBusy) {
+			spiBusy = true;
+			spin_unlock(spiLock, irq);
+			return;
+		}
+		spin_unlock(spiLock, irq);
+		tight_loop_contents();
+	}
+}
+
+void __not_in_flash_func(spiRelease)(spi_inst_t *spi) {
+	if (spi != SPI_GYRO) return;
+	const u32 irq = spin_lock_blocking(spiLock);
+	void (*deferred)() = spiDeferred;
+	spiDeferred = nullptr;
+	spiBusy = deferred != nullptr; // a deferred transfer takes over the claim
+	spin_unlock(spiLock, irq);
+	if (deferred) deferred();
+}
+
 // adapted from https://www.digikey.de/de/maker/projects/raspberry-pi-pico-rp2040-spi-example-with-micropython-and-cc/9706ea0cf3784ee98e35ff49188ee045
 int regRead(spi_inst_t *spi, const uint cs, const u8 reg, u8 *buf, const u16 nbytes, const u16 delay, u8 dummy) {
 	// Construct message (set ~W bit high)
 	u8 msg = 0x80 | reg;
 
 	// Read from register
+	spiAcquire(spi);
 	gpio_put(cs, 0);
 	spi_write_blocking(spi, &msg, 1);
 	if (dummy)
 		spi_read_blocking(spi, 0, buf, 1); // +1 for dummy byte
 	int num_bytes_read = spi_read_blocking(spi, 0, buf, nbytes);
 	gpio_put(cs, 1);
+	spiRelease(spi);
 
 	if (delay > 0)
 		sleep_us(delay);
@@ -20,16 +63,19 @@ int regRead(spi_inst_t *spi, const uint cs, const u8 reg, u8 *buf, const u16 nby
 
 int regWrite(spi_inst_t *spi, const uint cs, const u8 reg, const u8 *buf, const u16 nbytes, const u16 delay) {
 	// Write to register
+	spiAcquire(spi);
 	gpio_put(cs, 0);
 	spi_write_blocking(spi, &reg, 1);
 	int bytes_written = spi_write_blocking(spi, buf, nbytes);
 	gpio_put(cs, 1);
+	spiRelease(spi);
 	if (delay > 0)
 		sleep_us(delay);
 	return bytes_written;
 }
 
 void initDefaultSpi() {
+	spiLock = spin_lock_init(spin_lock_claim_unused(true));
 	spi_init(SPI_GYRO, 8000000);
 
 	spi_set_format(SPI_GYRO, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
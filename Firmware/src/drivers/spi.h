@@ -27,10 +27,38 @@ int regRead(spi_inst_t *spi, const uint cs, const u8 reg, u8 *buf, const u16 nby
  */
 int regWrite(spi_inst_t *spi, const uint cs, const u8 reg, const u8 *buf, const u16 nbytes = 1, const u16 delay = 0);
 
+/**
+ * @brief Claims the shared bus (SPI_GYRO) for a blocking transfer, other buses are not arbitrated
+ *
+ * @details Waits for a running gyro DMA read to finish. A read that is requested while the bus is claimed is started by spiRelease.
+ * regRead and regWrite do this on their own. The claim is guarded by a hardware spinlock, so spi0 may be used from both cores.
+ *
+ * @param spi SPI instance, spi0 or spi1
+ */
+void spiAcquire(spi_inst_t *spi);
+
+/**
+ * @brief Releases the bus after spiAcquire or a DMA transfer, and starts a transfer that was deferred by spiTryClaim
+ *
+ * @details The deferred transfer keeps the claim and runs on the releasing core, after the spinlock is released.
+ *
+ * @param spi SPI instance, spi0 or spi1
+ */
+void spiRelease(spi_inst_t *spi);
+
+/**
+ * @brief Claims SPI_GYRO for a DMA transfer without waiting, may be called from interrupts
+ *
+ * @param start called by spiRelease with the bus already claimed if the bus is busy right now
+ * @return true if the bus was claimed, release it with spiRelease once the transfer finished
+ */
+bool spiTryClaim(void (*start)());
+
 /**
  * @brief Initialize the default SPI bus
  *
  * @details initializes PIN_GYRO_CS, PIN_OSD_CS and PIN_BARO_CS as output pins
+ * claims the spinlock of the bus arbitration
  * initializes SPI_GYRO bus with 8 bits, CPOL=0, CPHA=0, MSB first and 8MHz
  */
 void initDefaultSpi();
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "global.h"
+#include <algorithm>
+
+#define SDFT_FIRST_BIN (DYN_NOTCH_MIN_FREQ * DYN_NOTCH_SDFT_SIZE / DYN_NOTCH_SAMPLE_FREQ - 1) // one more on each side for the window
+#define SDFT_LAST_BIN (DYN_NOTCH_MAX_FREQ * DYN_NOTCH_SDFT_SIZE / DYN_NOTCH_SAMPLE_FREQ + 1)
+#define SDFT_BINS (SDFT_LAST_BIN - SDFT_FIRST_BIN + 1)
+#define SDFT_DAMPING 0.9998f // keeps the rounding errors of the fixed point DFT from accumulating
+#define SDFT_SEARCH_INTERVAL (DYN_NOTCH_SDFT_SIZE / 4) // samples between two peak searches
+#define POWER_SMOOTHING 0.25f // weight of a new spectrum, averaging keeps noise from looking like peaks
+#define PEAK_MIN_RATIO 8.f // a peak has to be this much stronger (power) than the median of the searched bins
+#define PEAK_SMOOTHING 0.4f // weight of a new peak frequency
+
+volatile i32 dynNotchFreq[3][DYN_NOTCH_COUNT];
+
+// ring buffer core 1 -> core 0, only core 1 writes ringHead and only core 0 writes ringTail
+static fix32 ring[DYN_NOTCH_RING_SIZE][3];
+static volatile u32 ringHead = 0, ringTail = 0;
+static fix32 decimationSum[3];
+static u32 decimationCount = 0;
+
+// sliding DFT (core 0), the inputs are scaled by 1 / DYN_NOTCH_SDFT_SIZE, so that the bins stay in the fix32 range
+static fix32 sdftHistory[3][DYN_NOTCH_SDFT_SIZE];
+static u32 sdftPos = 0, sdftCount = 0;
+static i32 sdftRe[3][SDFT_BINS], sdftIm[3][SDFT_BINS]; // fix32 raw
+static i32 twiddleRe[SDFT_BINS], twiddleIm[SDFT_BINS]; // damping * e^(j 2 pi k / N), 2.30 fixed point
+static i32 dampingN; // damping^N, 2.30 fixed point
+static f32 sdftPower[3][SDFT_BINS]; // smoothed power spectrum, Hann windowed
+static f32 peakFreq[3][DYN_NOTCH_COUNT]; // smoothed, 0 = no peak
+
+// notches (core 1)
+static i32 notchB0[3][DYN_NOTCH_COUNT], notchA1[3][DYN_NOTCH_COUNT], notchA2[3][DYN_NOTCH_COUNT];
+static fix32 notchX1[3][DYN_NOTCH_COUNT], notchX2[3][DYN_NOTCH_COUNT], notchY1[3][DYN_NOTCH_COUNT], notchY2[3][DYN_NOTCH_COUNT];
+static u32 notchActive = 0; // bit per notch, axis * DYN_NOTCH_COUNT + index
+static u32 nextNotch = 0;
+
+void initDynNotch() {
+	ringHead = 0;
+	ringTail = 0;
+	decimationCount = 0;
+	sdftPos = 0;
+	sdftCount = 0;
+	memset(sdftHistory, 0, sizeof(sdftHistory));
+	memset(sdftRe, 0, sizeof(sdftRe));
+	memset(sdftIm, 0, sizeof(sdftIm));
+	memset(sdftPower, 0, sizeof(sdftPower));
+	memset(peakFreq, 0, sizeof(peakFreq));
+	for (int ax = 0; ax < 3; ax++) {
+		decimationSum[ax] = 0;
+		for (int i = 0; i < DYN_NOTCH_COUNT; i++)
+			dynNotchFreq[ax][i] = 0;
+	}
+	for (int k = 0; k < SDFT_BINS; k++) {
+		const f32 omega = 2 * (f32)PI * (k + SDFT_FIRST_BIN) / DYN_NOTCH_SDFT_SIZE;
+		twiddleRe[k] = SDFT_DAMPING * cosf(omega) * (1 << 30);
+		twiddleIm[k] = SDFT_DAMPING * sinf(omega) * (1 << 30);
+	}
+	dampingN = powf(SDFT_DAMPING, DYN_NOTCH_SDFT_SIZE) * (1 << 30);
+	notchActive = 0;
+	nextNotch = 0;
+}
+
+void __not_in_flash_func(dynNotchPush)(const fix32 data[3]) {
+	for (int ax = 0; ax < 3; ax++)
+		decimationSum[ax] += data[ax];
+	if (++decimationCount < DYN_NOTCH_DECIMATION) return;
+	decimationCount = 0;
+	const u32 head = ringHead;
+	if (head - ringTail >= DYN_NOTCH_RING_SIZE) {
+		tasks[TASK_DYN_NOTCH].errorCount++;
+		tasks[TASK_DYN_NOTCH].lastError = 1;
+	} else {
+		for (int ax = 0; ax < 3; ax++)
+			ring[head & (DYN_NOTCH_RING_SIZE - 1)][ax] = decimationSum[ax] / DYN_NOTCH_DECIMATION;
+		__dmb();
+		ringHead = head + 1;
+	}
+	for (int ax = 0; ax < 3; ax++)
+		decimationSum[ax] = 0;
+}
+
+bool dynNotchSamplesAvailable() {
+	return ringHead != ringTail;
+}
+
+/// @brief feeds one sample of one axis into the sliding DFT
+static void sdftUpdate(int ax, fix32 sample) {
+	const fix32 x = sample / DYN_NOTCH_SDFT_SIZE;
+	const i32 old = ((i64)sdftHistory[ax][sdftPos].raw * dampingN) >> 30;
+	sdftHistory[ax][sdftPos] = x;
+	const i32 delta = x.raw - old;
+	i32 *re = sdftRe[ax], *im = sdftIm[ax];
+	for (int k = 0; k < SDFT_BINS; k++) {
+		const i64 a = re[k] + delta, b = im[k];
+		re[k] = (a * twiddleRe[k] - b * twiddleIm[k]) >> 30;
+		im[k] = (a * twiddleIm[k] + b * twiddleRe[k]) >> 30;
+	}
+}
+
+/// @brief searches the strongest peaks of one axis and updates the smoothed peak frequencies
+static void findPeaks(int ax) {
+	// Hann window in the frequency domain: X[k] / 2 - (X[k - 1] + X[k + 1]) / 4
+	f32 *power = sdftPower[ax];
+	f32 sorted[SDFT_BINS - 2];
+	const i32 *re = sdftRe[ax], *im = sdftIm[ax];
+	for (int k = 1; k < SDFT_BINS - 1; k++) {
+		const f32 wr = (2 * re[k] - re[k - 1] - re[k + 1]) / 4.f;
+		const f32 wi = (2 * im[k] - im[k - 1] - im[k + 1]) / 4.f;
+		power[k] += POWER_SMOOTHING * (wr * wr + wi * wi - power[k]);
+		sorted[k - 1] = power[k];
+	}
+	// the median as noise floor, unlike the mean it does not rise with strong peaks
+	std::nth_element(sorted, sorted + (SDFT_BINS - 2) / 2, sorted + SDFT_BINS - 2);
+	const f32 threshold = sorted[(SDFT_BINS - 2) / 2] * PEAK_MIN_RATIO;
+
+	f32 found[DYN_NOTCH_COUNT] = {0}, foundPower[DYN_NOTCH_COUNT] = {0};
+	for (int k = 2; k < SDFT_BINS - 2; k++) {
+		const f32 p = power[k];
+		if (p <= threshold || p <= power[k - 1] || p < power[k + 1]) continue;
+		// parabolic interpolation of the peak position
+		const f32 denominator = power[k - 1] - 2 * p + power[k + 1];
+		const f32 offset = denominator < 0 ? 0.5f * (power[k - 1] - power[k + 1]) / denominator : 0;
+		const f32 freq = (k + SDFT_FIRST_BIN + offset) * DYN_NOTCH_SAMPLE_FREQ / DYN_NOTCH_SDFT_SIZE;
+		// insert into the strongest peaks
+		for (int i = 0; i < DYN_NOTCH_COUNT; i++) {
+			if (p > foundPower[i]) {
+				for (int j = DYN_NOTCH_COUNT - 1; j > i; j--) {
+					found[j] = found[j - 1];
+					foundPower[j] = foundPower[j - 1];
+				}
+				found[i] = freq;
+				foundPower[i] = p;
+				break;
+			}
+		}
+	}
+
+	// sort by frequency, so that a notch keeps following the same peak
+	for (int i = 1; i < DYN_NOTCH_COUNT; i++)
+		for (int j = i; j > 0 && found[j] && (!found[j - 1] || found[j] < found[j - 1]); j--) {
+			const f32 t = found[j];
+			found[j] = found[j - 1];
+			found[j - 1] = t;
+		}
+	for (int i = 0; i < DYN_NOTCH_COUNT; i++) {
+		f32 &f = peakFreq[ax][i];
+		if (!found[i])
+			f = 0;
+		else if (!f)
+			f = found[i];
+		else
+			f += PEAK_SMOOTHING * (found[i] - f);
+		dynNotchFreq[ax][i] = fix32(f).raw;
+	}
+}
+
+void dynNotchLoop() {
+	// at most a few samples per call, to stay within the scheduler budget
+	for (int n = 0; n < 4 && ringHead != ringTail; n++) {
+		const u32 tail = ringTail;
+		__dmb();
+		for (int ax = 0; ax < 3; ax++)
+			sdftUpdate(ax, ring[tail & (DYN_NOTCH_RING_SIZE - 1)][ax]);
+		__dmb();
+		ringTail = tail + 1;
+		sdftPos = (sdftPos + 1) % DYN_NOTCH_SDFT_SIZE;
+		if (++sdftCount >= DYN_NOTCH_SDFT_SIZE && sdftCount % SDFT_SEARCH_INTERVAL == 0) {
+			for (int ax = 0; ax < 3; ax++)
+				findPeaks(ax);
+			tasks[TASK_DYN_NOTCH].debugInfo = (u32)peakFreq[AXIS_ROLL][0]; // Hz
+		}
+	}
+}
+
+void __not_in_flash_func(dynNotchUpdate)() {
+	const u32 n = nextNotch;
+	nextNotch = (nextNotch + 1) % (3 * DYN_NOTCH_COUNT);
+	const u32 ax = n / DYN_NOTCH_COUNT, i = n % DYN_NOTCH_COUNT;
+	const fix32 freq = fix32().setRaw(dynNotchFreq[ax][i]);
+	if (freq < DYN_NOTCH_MIN_FREQ / 2) {
+		notchActive &= ~(1 << n);
+		return;
+	}
+	startFixTrig();
+	notchCoeffsFix(freq, DYN_NOTCH_Q, 3200, notchB0[ax][i], notchA1[ax][i], notchA2[ax][i]);
+	if (!(notchActive & (1 << n))) {
+		// start from the current signal level instead of 0, to avoid a step when the notch is switched on
+		notchX1[ax][i] = gyroData[ax];
+		notchX2[ax][i] = gyroData[ax];
+		notchY1[ax][i] = gyroData[ax];
+		notchY2[ax][i] = gyroData[ax];
+		notchActive |= 1 << n;
+	}
+}
+
+void __not_in_flash_func(dynNotchApply)(fix32 data[3]) {
+	if (!notchActive) return;
+	for (int ax = 0; ax < 3; ax++) {
+		for (int i = 0; i < DYN_NOTCH_COUNT; i++) {
+			if (notchActive & (1 << (ax * DYN_NOTCH_COUNT + i)))
+				data[ax] = notchStep(data[ax], notchB0[ax][i], notchA1[ax][i], notchA2[ax][i], notchX1[ax][i], notchX2[ax][i], notchY1[ax][i], notchY2[ax][i]);
+		}
+	}
+}
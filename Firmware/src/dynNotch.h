@@ -0,0 +1,53 @@
+#pragma once
+#include "typedefs.h"
+#include "utils/fixedPointInt.h"
+
+/*
+ * Dynamic notch
+ *
+ * Finds frame resonances that the RPM filter does not cover and places notches on them.
+ * Core 1 averages pairs of gyro samples (after the RPM filter) and hands them to core 0 through a ring buffer. On core 0,
+ * dynNotchLoop feeds them into a sliding DFT per axis (64 points at 1600 Hz, 25 Hz bins), and every 16 samples
+ * searches the Hann windowed spectrum between DYN_NOTCH_MIN_FREQ and DYN_NOTCH_MAX_FREQ for the DYN_NOTCH_COUNT strongest
+ * peaks. Their interpolated frequencies are handed back to core 1, where dynNotchUpdate recalculates one notch per loop.
+ */
+
+#define DYN_NOTCH_COUNT 2 // notches per axis
+#define DYN_NOTCH_Q 3 // center frequency / bandwidth
+#define DYN_NOTCH_DECIMATION 2 // gyro samples per analyzed sample
+#define DYN_NOTCH_SAMPLE_FREQ (3200 / DYN_NOTCH_DECIMATION)
+#define DYN_NOTCH_SDFT_SIZE 64 // points of the sliding DFT, 25 Hz bins
+#define DYN_NOTCH_MIN_FREQ 100 // Hz
+#define DYN_NOTCH_MAX_FREQ 600 // Hz
+#define DYN_NOTCH_RING_SIZE 64 // samples, power of 2 (40 ms at 1600 Hz)
+
+extern volatile i32 dynNotchFreq[3][DYN_NOTCH_COUNT]; // center frequencies from core 0, fix32 raw in Hz, 0 = no peak
+
+/// @brief resets the analysis and disables all dynamic notches
+void initDynNotch();
+
+/**
+ * @brief hands a filtered gyro sample to the spectrum analysis on core 0
+ * @details every DYN_NOTCH_DECIMATION samples, one averaged sample is put into the ring buffer, if core 0 does not keep up,
+ * the sample is dropped and counted as an error of TASK_DYN_NOTCH
+ * @param data gyro data of the 3 axes
+ */
+void dynNotchPush(const fix32 data[3]);
+
+/// @brief true if samples for dynNotchLoop are waiting
+bool dynNotchSamplesAvailable();
+
+/// @brief core 0 task: runs the sliding DFT on the waiting samples and publishes the peak frequencies
+void dynNotchLoop();
+
+/**
+ * @brief recalculates the coefficients of one dynamic notch from the published frequencies
+ * @details independent of the gyro sample, called in pidPrepare
+ */
+void dynNotchUpdate();
+
+/**
+ * @brief filters the gyro data with the active dynamic notches
+ * @param data gyro data of the 3 axes, filtered in place
+ */
+void dynNotchApply(fix32 data[3]);
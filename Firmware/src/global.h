@@ -6,6 +6,7 @@
 #include <Adafruit_TinyUSB.h>
 #endif
 #include <Arduino.h>
+#include "timebase.h" // needed by the headers below
 
 #if BLACKBOX_STORAGE == LITTLEFS_BB
 #include "LittleFS.h"
@@ -15,6 +16,7 @@
 #include "EEPROM.h"
 #include "EEPROMImpl.h"
 #include "adc.h"
+#include "benchmark.h"
 #include "blackbox.h"
 #include "drivers/baro.h"
 #include "drivers/esc.h"
@@ -23,16 +25,19 @@
 #include "drivers/osd.h"
 #include "drivers/speaker.h"
 #include "drivers/spi.h"
+#include "dynNotch.h"
 #include "elapsedMillis.h"
 #include "git_version.h"
 #include "hardware/adc.h"
 #include "hardware/dma.h"
 #include "hardware/i2c.h"
+#include "hardware/irq.h"
 #include "hardware/pio.h"
 #include "hardware/pwm.h"
 #include "hardware/resets.h"
 #include "hardware/rtc.h"
 #include "hardware/spi.h"
+#include "hardware/sync.h"
 #include "hardware/watchdog.h"
 #include "imu.h"
 #include "modes.h"
@@ -43,6 +48,7 @@
 #include "pioasm/dshotx4.pio.h"
 #include "pioasm/speaker8bit.pio.h"
 #include "ringbuffer.h"
+#include "rpmFilter.h"
 #include "rtc.h"
 #include "serial.h"
 #include "serialhandler/4way.h"
@@ -50,10 +56,12 @@
 #include "serialhandler/gps.h"
 #include "serialhandler/msp.h"
 #include "taskManager.h"
+#include "trace.h"
 #include "unittest.h"
 #include "utils/filters.h"
 #include "utils/fixedPointInt.h"
 #include "utils/quaternion.h"
+#include "utils/quaternionFix.h"
 
 #define SPI_GYRO spi0 // SPI for gyro
 #define SPI_OSD spi0 // SPI for OSD
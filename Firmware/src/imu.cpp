@@ -12,11 +12,13 @@
 // Z: up / yaw left
 
 const f32 RAW_TO_RAD_PER_SEC = PI * 4000 / 65536 / 180; // 2000deg per second, but raw is only +/-.5
-const f32 FRAME_TIME = 1. / 3200;
-const f32 RAW_TO_HALF_ANGLE = RAW_TO_RAD_PER_SEC * FRAME_TIME / 2;
-const f32 ANGLE_CHANGE_LIMIT = .0002;
+// half angle in 2.30 per raw gyro unit and us, scaled by 2^32 to keep the precision of the 16.16 sample time
+const u32 RAW_TO_HALF_ANGLE_PER_US = RAW_TO_RAD_PER_SEC / 1000000 / 2 * QUAT_FIX_ONE * 4294967296.;
+const f32 ANGLE_CHANGE_LIMIT = .0002 * ACCEL_FUSION_DIVIDER; // per fusion step, same correction per second at any ACCEL_RATE
+const i32 ANGLE_CHANGE_LIMIT_HALF = ANGLE_CHANGE_LIMIT / 2 * QUAT_FIX_ONE; // 2.30
+const i64 ANGLE_CHANGE_LIMIT_SQ = (f64)ANGLE_CHANGE_LIMIT * ANGLE_CHANGE_LIMIT * QUAT_FIX_ONE * QUAT_FIX_ONE; // 4.60, ~sin^2
 const fix32 RAW_TO_M_PER_SEC2 = (9.81 * 32 + 0.5) / 65536; // +/-16g (0.5 for rounding)
-PT1 accelDataFiltered[3] = {PT1(100, 3200), PT1(100, 3200), PT1(100, 3200)};
+PT1N<3> accelDataFiltered(100, ACCEL_RATE);
 
 fix32 roll, pitch, yaw;
 fix32 combinedHeading; // NOT heading of motion, but heading of quad
@@ -26,91 +28,128 @@ fix32 vVel, combinedAltitude, vVelHelper;
 fix32 eVel, nVel;
 fix32 vAccel;
 
-Quaternion q;
+QuaternionFix q;
+static u32 accelFusionPhase = 0; // next phase of updateFromAccel
 
 void imuInit() {
 	pitch = 0; // pitch up
 	roll = 0; // roll right
 	yaw = 0; // yaw right
-	q.w = 1;
-	q.v[0] = 0;
-	q.v[1] = 0;
-	q.v[2] = 0;
+	QuaternionFix_setIdentity(&q);
+	accelFusionPhase = 0;
 	initFixTrig();
 	magHeadingCorrection.setRolloverParams(-PI, PI);
 }
 
 void __not_in_flash_func(updateFromGyro)() {
-	// quaternion of all 3 axis rotations combined
-
-	f32 all[] = {-gyroDataRaw[1] * RAW_TO_HALF_ANGLE, -gyroDataRaw[0] * RAW_TO_HALF_ANGLE, gyroDataRaw[2] * RAW_TO_HALF_ANGLE};
-	Quaternion buffer = q;
-	q.w += (-buffer.v[0] * all[0] - buffer.v[1] * all[1] - buffer.v[2] * all[2]);
-	q.v[0] += (+buffer.w * all[0] - buffer.v[1] * all[2] + buffer.v[2] * all[1]);
-	q.v[1] += (+buffer.w * all[1] + buffer.v[0] * all[2] - buffer.v[2] * all[0]);
-	q.v[2] += (+buffer.w * all[2] - buffer.v[0] * all[1] + buffer.v[1] * all[0]);
-
-	Quaternion_normalize(&q, &q);
+	// quaternion of all 3 axis rotations combined, over the time since the last sample (sensor time)
+	const i32 rawToHalfAngle = ((u64)(u32)gyroSampleDtUs.raw * RAW_TO_HALF_ANGLE_PER_US) >> 32; // 2.30 << 16
+	const i32 all[] = {
+		(i32)(((i64)-gyroDataRaw[1] * rawToHalfAngle) >> 16),
+		(i32)(((i64)-gyroDataRaw[0] * rawToHalfAngle) >> 16),
+		(i32)(((i64)gyroDataRaw[2] * rawToHalfAngle) >> 16),
+	};
+	const QuaternionFix buffer = q;
+	q.w += (-quatFixMul(buffer.v[0], all[0]) - quatFixMul(buffer.v[1], all[1]) - quatFixMul(buffer.v[2], all[2]));
+	q.v[0] += (+quatFixMul(buffer.w, all[0]) - quatFixMul(buffer.v[1], all[2]) + quatFixMul(buffer.v[2], all[1]));
+	q.v[1] += (+quatFixMul(buffer.w, all[1]) + quatFixMul(buffer.v[0], all[2]) - quatFixMul(buffer.v[2], all[0]));
+	q.v[2] += (+quatFixMul(buffer.w, all[2]) - quatFixMul(buffer.v[0], all[1]) + quatFixMul(buffer.v[1], all[0]));
+
+	QuaternionFix_normalize(&q);
 }
 
-f32 orientation_vector[3];
+/**
+ * @brief one phase of the accel fusion, a step takes ACCEL_FUSION_PHASES loops and starts every ACCEL_FUSION_DIVIDER loops
+ * @details 0: accel filter, expected and measured down vector, 1: rotation axis (cross product) between them, 2: limited
+ * correction of the attitude. All in 2.30 fixed point. The correction is applied a few loops after the measurement, which
+ * does not matter for its size.
+ */
 void __not_in_flash_func(updateFromAccel)() {
-	// filter accel data
-	accelDataFiltered[0].update(accelDataRaw[0]);
-	accelDataFiltered[1].update(accelDataRaw[1]);
-	accelDataFiltered[2].update(accelDataRaw[2]);
-
-	// Formula from http://www.euclideanspace.com/maths/algebra/realNormedAlgebra/quaternions/transforms/index.htm
-	// p2.x = w*w*p1.x + 2*y*w*p1.z - 2*z*w*p1.y + x*x*p1.x + 2*y*x*p1.y + 2*z*x*p1.z - z*z*p1.x - y*y*p1.x;
-	// p2.y = 2*x*y*p1.x + y*y*p1.y + 2*z*y*p1.z + 2*w*z*p1.x - z*z*p1.y + w*w*p1.y - 2*x*w*p1.z - x*x*p1.y;
-	// p2.z = 2*x*z*p1.x + 2*y*z*p1.y + z*z*p1.z - 2*w*y*p1.x - y*y*p1.z + 2*w*x*p1.y - x*x*p1.z + w*w*p1.z;
-	// with p1.x = 0, p1.y = 0, p1.z = -1, things can be simplified
-
-	orientation_vector[0] = q.w * q.v[1] * -2 + q.v[0] * q.v[2] * -2;
-	orientation_vector[1] = q.v[1] * q.v[2] * -2 + q.w * q.v[0] * 2;
-	orientation_vector[2] = -q.v[2] * q.v[2] + q.v[1] * q.v[1] + q.v[0] * q.v[0] - q.w * q.w;
-
-	f32 accelVectorNorm = sqrtf((i32)accelDataRaw[1] * (i32)accelDataRaw[1] + (i32)accelDataRaw[0] * (i32)accelDataRaw[0] + (i32)accelDataRaw[2] * (i32)accelDataRaw[2]);
-	f32 accelVector[3];
-	if (accelVectorNorm > 0.01f) {
-		f32 invAccelVectorNorm = 1 / accelVectorNorm;
-		accelVector[0] = invAccelVectorNorm * accelDataRaw[1];
-		accelVector[1] = invAccelVectorNorm * accelDataRaw[0];
-		accelVector[2] = invAccelVectorNorm * -accelDataRaw[2];
-	} else
-		return;
-	Quaternion shortest_path;
-	Quaternion_from_unit_vecs(orientation_vector, accelVector, &shortest_path);
-
-	f32 axis[3];
-	f32 accAngle = Quaternion_toAxisAngle(&shortest_path, axis); // reduces effect of accel noise on attitude
-
-	if (accAngle > ANGLE_CHANGE_LIMIT) accAngle = ANGLE_CHANGE_LIMIT;
-
-	// Quaternion c;
-	// Quaternion_fromAxisAngle(axis, accAngle, &c);
-	// Quaternion_multiply(&c, &q, &q);
-	f32 c[3]; // correction quaternion, but w is 1
-	f32 co = accAngle * 0.5f;
-	c[0] = axis[0] * co;
-	c[1] = axis[1] * co;
-	c[2] = axis[2] * co;
-
-	Quaternion buffer;
-	buffer.w = q.w - c[0] * q.v[0] - c[1] * q.v[1] - c[2] * q.v[2];
-	buffer.v[0] = c[0] * q.w + q.v[0] + c[1] * q.v[2] - c[2] * q.v[1];
-	buffer.v[1] = q.v[1] - c[0] * q.v[2] + c[1] * q.w + c[2] * q.v[0];
-	buffer.v[2] = q.v[2] + c[0] * q.v[1] - c[1] * q.v[0] + c[2] * q.w;
-	q = buffer;
-
-	Quaternion_normalize(&q, &q);
+	static i32 orientationVector[3], accelVector[3], cross[3];
+	static i32 dot;
+	const u32 p = accelFusionPhase;
+	if (++accelFusionPhase >= ACCEL_FUSION_DIVIDER) accelFusionPhase = 0;
+
+	startFixTrig(); // for quatFixInvSqrt
+	switch (p) {
+	case 0: {
+		// filter accel data
+		accelDataFiltered.update(accelDataRaw);
+
+		// Formula from http://www.euclideanspace.com/maths/algebra/realNormedAlgebra/quaternions/transforms/index.htm
+		// p2.x = w*w*p1.x + 2*y*w*p1.z - 2*z*w*p1.y + x*x*p1.x + 2*y*x*p1.y + 2*z*x*p1.z - z*z*p1.x - y*y*p1.x;
+		// p2.y = 2*x*y*p1.x + y*y*p1.y + 2*z*y*p1.z + 2*w*z*p1.x - z*z*p1.y + w*w*p1.y - 2*x*w*p1.z - x*x*p1.y;
+		// p2.z = 2*x*z*p1.x + 2*y*z*p1.y + z*z*p1.z - 2*w*y*p1.x - y*y*p1.z + 2*w*x*p1.y - x*x*p1.z + w*w*p1.z;
+		// with p1.x = 0, p1.y = 0, p1.z = -1, things can be simplified
+
+		orientationVector[0] = -((i64)q.w * q.v[1] + (i64)q.v[0] * q.v[2]) >> (QUAT_FIX_SHIFT - 1);
+		orientationVector[1] = ((i64)q.w * q.v[0] - (i64)q.v[1] * q.v[2]) >> (QUAT_FIX_SHIFT - 1);
+		orientationVector[2] = (-(i64)q.v[2] * q.v[2] + (i64)q.v[1] * q.v[1] + (i64)q.v[0] * q.v[0] - (i64)q.w * q.w) >> QUAT_FIX_SHIFT;
+
+		// each square fits into i32, their sum (up to 3.2e9 near full scale) only into u32
+		const u32 accelNormSq = (u32)((i32)accelDataRaw[1] * accelDataRaw[1]) + (u32)((i32)accelDataRaw[0] * accelDataRaw[0]) + (u32)((i32)accelDataRaw[2] * accelDataRaw[2]);
+		if (accelNormSq) {
+			i32 halfShift;
+			const i32 invNorm = quatFixInvSqrt(accelNormSq, &halfShift);
+			accelVector[0] = ((i64)accelDataRaw[1] * invNorm) >> (15 - halfShift);
+			accelVector[1] = ((i64)accelDataRaw[0] * invNorm) >> (15 - halfShift);
+			accelVector[2] = ((i64)-accelDataRaw[2] * invNorm) >> (15 - halfShift);
+		} else
+			accelFusionPhase = ACCEL_FUSION_PHASES; // no usable measurement, skip the rest of this step
+		break;
+	}
+	case 1: {
+		// rotation from the expected to the measured down vector: axis along the cross product, |cross| = sin(angle)
+		const i32 *o = orientationVector, *a = accelVector;
+		cross[0] = ((i64)o[1] * a[2] - (i64)o[2] * a[1]) >> QUAT_FIX_SHIFT;
+		cross[1] = ((i64)o[2] * a[0] - (i64)o[0] * a[2]) >> QUAT_FIX_SHIFT;
+		cross[2] = ((i64)o[0] * a[1] - (i64)o[1] * a[0]) >> QUAT_FIX_SHIFT;
+		dot = ((i64)o[0] * a[0] + (i64)o[1] * a[1] + (i64)o[2] * a[2]) >> QUAT_FIX_SHIFT;
+		if (dot < 0 && !cross[0] && !cross[1] && !cross[2]) {
+			// upside down: rotate around any axis orthogonal to the expected down vector
+			cross[1] = -o[2];
+			cross[2] = o[1];
+		}
+		break;
+	}
+	case 2: {
+		// correction quaternion, but w is 1: half angle times the axis, limited to reduce the effect of accel noise on attitude
+		i32 c[3];
+		const i64 crossSq = (i64)cross[0] * cross[0] + (i64)cross[1] * cross[1] + (i64)cross[2] * cross[2];
+		if (dot > 0 && crossSq <= ANGLE_CHANGE_LIMIT_SQ) {
+			// small angle, sin(angle) = angle
+			c[0] = cross[0] >> 1;
+			c[1] = cross[1] >> 1;
+			c[2] = cross[2] >> 1;
+		} else {
+			const u32 crossSqShort = crossSq >> QUAT_FIX_SHIFT;
+			if (!crossSqShort) break; // no usable axis
+			i32 halfShift;
+			const i32 scale = quatFixMul(quatFixInvSqrt(crossSqShort, &halfShift), ANGLE_CHANGE_LIMIT_HALF);
+			c[0] = ((i64)cross[0] * scale) >> (QUAT_FIX_SHIFT - halfShift);
+			c[1] = ((i64)cross[1] * scale) >> (QUAT_FIX_SHIFT - halfShift);
+			c[2] = ((i64)cross[2] * scale) >> (QUAT_FIX_SHIFT - halfShift);
+		}
+
+		QuaternionFix buffer;
+		buffer.w = q.w - quatFixMul(c[0], q.v[0]) - quatFixMul(c[1], q.v[1]) - quatFixMul(c[2], q.v[2]);
+		buffer.v[0] = quatFixMul(c[0], q.w) + q.v[0] + quatFixMul(c[1], q.v[2]) - quatFixMul(c[2], q.v[1]);
+		buffer.v[1] = q.v[1] - quatFixMul(c[0], q.v[2]) + quatFixMul(c[1], q.w) + quatFixMul(c[2], q.v[0]);
+		buffer.v[2] = q.v[2] + quatFixMul(c[0], q.v[1]) - quatFixMul(c[1], q.v[0]) + quatFixMul(c[2], q.w);
+		q = buffer;
+
+		QuaternionFix_normalize(&q);
+		break;
+	}
+	}
 }
 
 void __not_in_flash_func(updatePitchRollValues)() {
 	startFixTrig();
-	roll = atan2Fix(2 * (q.w * q.v[0] - q.v[1] * q.v[2]), 1 - 2 * (q.v[0] * q.v[0] + q.v[1] * q.v[1]));
-	pitch = asinf(2 * (q.w * q.v[1] + q.v[2] * q.v[0]));
-	yaw = atan2Fix(2 * (q.v[0] * q.v[1] - q.w * q.v[2]), 1 - 2 * (q.v[1] * q.v[1] + q.v[2] * q.v[2]));
+	// 2 * (2.30 * 2.30) >> 43 = 16.16
+	roll = atan2Fix(fix32().setRaw(((i64)q.w * q.v[0] - (i64)q.v[1] * q.v[2]) >> 43), fix32(1) - fix32().setRaw(((i64)q.v[0] * q.v[0] + (i64)q.v[1] * q.v[1]) >> 43));
+	pitch = asinFix(fix32().setRaw(((i64)q.w * q.v[1] + (i64)q.v[2] * q.v[0]) >> 43));
+	yaw = atan2Fix(fix32().setRaw(((i64)q.v[0] * q.v[1] - (i64)q.w * q.v[2]) >> 43), fix32(1) - fix32().setRaw(((i64)q.v[1] * q.v[1] + (i64)q.v[2] * q.v[2]) >> 43));
 	fix32 temp = (fix32)magHeadingCorrection + yaw;
 	if (temp >= FIX_PI) {
 		temp -= FIX_2PI;
@@ -146,46 +185,17 @@ void __not_in_flash_func(updatePitchRollValues)() {
 }
 
 void updateAttitude() {
-	elapsedMicros taskTimer = 0;
-	tasks[TASK_IMU].runCounter++;
-	u32 t0, t1, t2;
-	elapsedMicros timer = 0;
-	updateFromGyro();
-	t0 = timer;
-	updateFromAccel();
-	t1 = timer;
-	updatePitchRollValues();
-	t2 = timer;
-	tasks[TASK_IMU_GYRO].totalDuration += t0;
-	tasks[TASK_IMU_ACCEL].totalDuration += t1 - t0;
-	tasks[TASK_IMU_ANGLE].totalDuration += t2 - t1;
-	if (t0 < tasks[TASK_IMU_GYRO].minDuration) {
-		tasks[TASK_IMU_GYRO].minDuration = t0;
-	}
-	if (t0 > tasks[TASK_IMU_GYRO].maxDuration) {
-		tasks[TASK_IMU_GYRO].maxDuration = t0;
-	}
-	if (t1 - t0 < tasks[TASK_IMU_ACCEL].minDuration) {
-		tasks[TASK_IMU_ACCEL].minDuration = t1 - t0;
-	}
-	if (t1 - t0 > tasks[TASK_IMU_ACCEL].maxDuration) {
-		tasks[TASK_IMU_ACCEL].maxDuration = t1 - t0;
-	}
-	if (t2 - t1 < tasks[TASK_IMU_ANGLE].minDuration) {
-		tasks[TASK_IMU_ANGLE].minDuration = t2 - t1;
-	}
-	if (t2 - t1 > tasks[TASK_IMU_ANGLE].maxDuration) {
-		tasks[TASK_IMU_ANGLE].maxDuration = t2 - t1;
+	TASK_PROBE(TASK_IMU);
+	{
+		TASK_PROBE(TASK_IMU_GYRO);
+		updateFromGyro();
 	}
-	tasks[TASK_IMU_GYRO].runCounter++;
-	tasks[TASK_IMU_ACCEL].runCounter++;
-	tasks[TASK_IMU_ANGLE].runCounter++;
-	u32 duration = taskTimer;
-	tasks[TASK_IMU].totalDuration += duration;
-	if (duration < tasks[TASK_IMU].minDuration) {
-		tasks[TASK_IMU].minDuration = duration;
+	{
+		TASK_PROBE(TASK_IMU_ACCEL);
+		updateFromAccel();
 	}
-	if (duration > tasks[TASK_IMU].maxDuration) {
-		tasks[TASK_IMU].maxDuration = duration;
+	{
+		TASK_PROBE(TASK_IMU_ANGLE);
+		updatePitchRollValues();
 	}
 }
\ No newline at end of file
@@ -1,8 +1,13 @@
+#include "drivers/gyro.h"
 #include "utils/filters.h"
 #include "utils/fixedPointInt.h"
-#include "utils/quaternion.h"
+#include "utils/quaternionFix.h"
 #include <Arduino.h>
 
+#define ACCEL_FUSION_PHASES 3 // PID loops that one accel fusion step is spread over, see updateFromAccel
+#define ACCEL_FUSION_DIVIDER (3200 / ACCEL_RATE) // PID loops per accel fusion step
+static_assert(ACCEL_FUSION_DIVIDER >= ACCEL_FUSION_PHASES, "one accel fusion step per ACCEL_FUSION_PHASES loops at most");
+
 extern fix32 roll, pitch, yaw; // Euler angles of the drone
 extern fix32 combinedHeading; // heading of the drone (in rad) by combining the magnetometer and the gyro
 extern fix32 cosRoll, cosPitch, cosYaw, cosHeading, sinRoll, sinPitch, sinYaw, sinHeading;
@@ -11,16 +16,27 @@ extern fix32 vVel; // vertical velocity of the drone (up = positive, m/s)
 extern fix32 combinedAltitude; // altitude of the drone (in meters ASL) by combining the barometer, GPS and the accelerometer
 extern fix32 eVel; // east velocity of the drone (m/s) by GPS (filtered)
 extern fix32 nVel; // north velocity of the drone (m/s) by GPS (filtered)
-extern PT1 accelDataFiltered[3]; // PT1 filters for the accelerometer data
+extern PT1N<3> accelDataFiltered; // PT1 filters for the accelerometer data, updated at ACCEL_RATE
 extern fix32 vAccel; // vertical up acceleration of the drone (m/s^2) provided by the accelerometer
+extern QuaternionFix q; // attitude of the drone, 2.30 fixed point
 
 /**
  * @brief initialize the IMU
- * @details setting start values for quaternion, attitude angles and mag filter rollover
+ * @details setting start values for quaternion, attitude angles and mag filter rollover, restarts the accel fusion step
  */
 void imuInit();
+/**
+ * @brief integrates the gyro data of one sample into the attitude quaternion
+ * @details Uses gyroSampleDtUs, called by updateAttitude and for the samples that queued up during a stall
+ */
+void updateFromGyro();
+/**
+ * @brief runs the next phase of the accel fusion, a full step takes ACCEL_FUSION_PHASES calls after imuInit
+ * @details Called by updateAttitude, uses accelDataRaw
+ */
+void updateFromAccel();
 /**
  * @brief update the attitude of the drone
- * @details 1. feeds gyro data into the attitude quaternion, 2. filters and feeds accelerometer values into the quaternion to prevent drift, 3. updates roll, pitch and yaw values, as well as combined heading, altitude and vVel via the filtered data
+ * @details 1. feeds gyro data into the attitude quaternion, 2. filters and feeds accelerometer values into the quaternion to prevent drift (at ACCEL_RATE, one phase per loop), 3. updates roll, pitch and yaw values, as well as combined heading, altitude and vVel via the filtered data
  */
 void updateAttitude();
\ No newline at end of file
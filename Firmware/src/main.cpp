@@ -4,6 +4,8 @@
 volatile u8 setupDone = 0b00;
 
 void setup() {
+	initCycleCounter();
+	updateLoopTime();
 	Serial.begin(115200);
 
 	runUnitTests();
@@ -40,7 +42,6 @@ void setup() {
 	initADC();
 	modesInit();
 	initMag();
-	initSerial();
 
 	// init ELRS on pins 0 and 1 using Serial1 (UART0)
 	ELRS = new ExpressLRS(Serial1, 420000, PIN_TX0, PIN_RX0);
@@ -55,9 +56,8 @@ void setup() {
 	initSpeaker();
 	rp2040.wdt_begin(200);
 
+	updateLoopTime();
 	Serial.println("Setup complete");
-	extern elapsedMicros taskTimer0;
-	taskTimer0 = 0;
 	setupDone |= 0b01;
 	while (!(setupDone & 0b10)) {
 		rp2040.wdt_reset();
@@ -65,69 +65,59 @@ void setup() {
 	xip_ctrl_hw->flush = 1;
 }
 
-elapsedMillis activityTimer;
+void toggleActivityLed() {
+	gpio_put(PIN_LED_ACTIVITY, !gpio_get(PIN_LED_ACTIVITY));
+}
+
+// run, ready, taskId, priority, period (µs), budget (µs)
+SchedulerTask core0Tasks[] = {
+	{[] { ELRS->loop(); }, nullptr, TASK_ELRS, 10, 0, 50},
+	{serialLoop, nullptr, TASK_SERIAL, 10, 0, 100},
+	{modesLoop, nullptr, TASK_MODES, 8, 0, 50},
+	{blackboxLoop, [] { return rp2040.fifo.available() && bbLogging && fsReady; }, TASK_BLACKBOX, 7, 0, 200},
+	{speakerLoop, nullptr, TASK_SPEAKER, 5, 0, 20},
+	{dynNotchLoop, dynNotchSamplesAvailable, TASK_DYN_NOTCH, 4, 0, 100},
+	{gpsLoop, nullptr, TASK_GPS, 4, 0, 100},
+	{evalBaroLoop, [] { return (bool)newBaroData; }, TASK_BAROEVAL, 3, 0, 50},
+	{magLoop, nullptr, TASK_MAGNETOMETER, 3, 0, 100},
+	{adcLoop, nullptr, TASK_ADC, 2, 50000, 50},
+	{configuratorLoop, nullptr, TASK_NONE, 2, 0, 50},
+	{taskManagerLoop, nullptr, TASK_TASKMANAGER, 1, 1000000, 20},
+	{toggleActivityLed, nullptr, TASK_NONE, 1, 500000, 5},
+};
 
-elapsedMicros taskTimer0;
 void loop() {
-	tasks[TASK_LOOP0].runCounter++;
-	u32 duration0 = taskTimer0;
-	if (duration0 > tasks[TASK_LOOP0].maxGap) {
-		tasks[TASK_LOOP0].maxGap = duration0;
-	}
-	taskTimer0 = 0;
-	speakerLoop();
-	evalBaroLoop();
-	blackboxLoop();
-	ELRS->loop();
-	modesLoop();
-	adcLoop();
-	serialLoop();
-	configuratorLoop();
-	gpsLoop();
-	magLoop();
-	taskManagerLoop();
+	updateLoopTime();
+	TASK_PROBE(TASK_LOOP0);
+	schedulerLoop(core0Tasks, ARRAYLEN(core0Tasks));
 	rp2040.wdt_reset();
-	if (activityTimer >= 500) {
-		gpio_put(PIN_LED_ACTIVITY, !gpio_get(PIN_LED_ACTIVITY));
-		activityTimer = 0;
-	}
-	duration0 = taskTimer0;
-	tasks[TASK_LOOP0].totalDuration += duration0;
-	if (duration0 > tasks[TASK_LOOP0].maxDuration) {
-		tasks[TASK_LOOP0].maxDuration = duration0;
-	}
-	if (duration0 < tasks[TASK_LOOP0].minDuration) {
-		tasks[TASK_LOOP0].minDuration = duration0;
-	}
-	taskTimer0 = 0;
 }
 
 u32 *speakerRxPacket;
 void setup1() {
 	while (!(setupDone & 0b01)) {
 	}
+	initCycleCounter();
+	updateLoopTime();
 	initESCs();
+	gyroStartAcquisition(); // the gyro interrupts run on this core
 	setupDone |= 0b10;
 	while (!(setupDone & 0b01)) {
 	}
 }
-elapsedMicros taskTimer = 0;
 u32 taskState = 0;
 
 extern PIO speakerPio;
 extern u8 speakerSm;
 void loop1() {
-	tasks[TASK_LOOP1].runCounter++;
-	u32 duration = taskTimer;
-	if (duration > tasks[TASK_LOOP1].maxGap) {
-		tasks[TASK_LOOP1].maxGap = duration;
-	}
-	taskTimer = 0;
+	updateLoopTime();
+	TASK_PROBE(TASK_LOOP1);
 	gyroLoop();
+	benchmarkLoop();
 	if (gyroUpdateFlag & 1) {
 		switch (taskState++) {
 		case 0:
-			osdLoop(); // slow, but both need to be on this core, due to SPI collision
+			osdLoop(); // slow, but its spi0 transfers wait for the gyro DMA through spiAcquire anyway
 			break;
 		case 1:
 			readBaroLoop();
@@ -136,13 +126,4 @@ void loop1() {
 		if (taskState == 2) taskState = 0;
 		gyroUpdateFlag &= ~1;
 	}
-	duration = taskTimer;
-	tasks[TASK_LOOP1].totalDuration += duration;
-	if (duration > tasks[TASK_LOOP1].maxDuration) {
-		tasks[TASK_LOOP1].maxDuration = duration;
-	}
-	if (duration < tasks[TASK_LOOP1].minDuration) {
-		tasks[TASK_LOOP1].minDuration = duration;
-	}
-	taskTimer = 0;
 }
\ No newline at end of file
@@ -15,8 +15,6 @@ u32 armingDisableFlags = 0;
 
 void modesLoop() {
 	if (ELRS->newPacketFlag & 0x00000001) {
-		elapsedMicros taskTimer = 0;
-		tasks[TASK_MODES].runCounter++;
 		ELRS->newPacketFlag &= 0xFFFFFFFE;
 		if (!armed) {
 			if (ELRS->consecutiveArmedCycles == 10)
@@ -102,14 +100,6 @@ void modesLoop() {
 			}
 			flightMode = newFlightMode;
 		}
-		u32 duration = taskTimer;
-		tasks[TASK_MODES].totalDuration += duration;
-		if (duration < tasks[TASK_MODES].minDuration) {
-			tasks[TASK_MODES].minDuration = duration;
-		}
-		if (duration > tasks[TASK_MODES].maxDuration) {
-			tasks[TASK_MODES].maxDuration = duration;
-		}
 	} else if (ELRS->sinceLastRCMessage >= 500000) {
 		armed = false;
 		endLogging();
@@ -30,7 +30,11 @@ fix32 rollP, pitchP, yawP, rollI, pitchI, yawI, rollD, pitchD, yawD, rollFF, pit
 fix32 altSetpoint;
 fix32 tRR, tRL, tFR, tFL;
 fix32 throttle;
-PT1 dFilterRoll(100, 3200), dFilterPitch(100, 3200), dFilterYaw(100, 3200);
+PT1N<3> dFilter(DTERM_LPF_MIN, 3200);
+BiquadN<3> gyroFilter(BiquadType::LOWPASS, GYRO_LPF_MIN, 3200);
+// cutoff increase per throttle step (throttle is IDLE_PERMILLE * 2 ... 2000 after the mixer)
+static const fix32 GYRO_LPF_SLOPE = fix32((GYRO_LPF_MAX - GYRO_LPF_MIN) / 2000.f);
+static const fix32 DTERM_LPF_SLOPE = fix32((DTERM_LPF_MAX - DTERM_LPF_MIN) / 2000.f);
 
 fix32 rollSetpoints[8], pitchSetpoints[8], yawSetpoints[8];
 
@@ -70,44 +74,59 @@ void initPID() {
 	pidGainsHVel[D] = 0; // tilt in degrees, if changing speed by 3200m/s /s
 	vVelMaxErrorSum = 1024 / pidGainsVVel[I].getf32();
 	vVelMinErrorSum = IDLE_PERMILLE * 2 / pidGainsVVel[I].getf32();
+	initRpmFilter();
+	initDynNotch();
 }
 
 u32 takeoffCounter = 0;
-elapsedMicros taskTimerGyro, taskTimerPid;
-void pidLoop() {
-	u32 duration = taskTimerGyro;
-	if (tasks[TASK_GYROREAD].maxGap < duration)
-		tasks[TASK_GYROREAD].maxGap = duration;
-	taskTimerGyro = 0;
-	tasks[TASK_GYROREAD].runCounter++;
+void pidPrepare() {
+	decodeErpm();
+	rpmFilterUpdate();
+	dynNotchUpdate();
+	{
+		// the throttle of the last loop, table lookups instead of divisions
+		const fix32 t = armed ? constrain(throttle, 0, 2000) : fix32(0);
+		const fix32 gyroCutoff = GYRO_LPF_SLOPE * t + GYRO_LPF_MIN;
+		const fix32 dCutoff = DTERM_LPF_SLOPE * t + DTERM_LPF_MIN;
+		gyroFilter.updateLowpassLut(gyroCutoff);
+		dFilter.updateCutoffFreqLut(dCutoff);
+	}
+	if (armed)
+		ELRS->getSmoothChannels(smoothChannels);
+}
+
+/// @brief takes the next gyro sample and runs it through the gyro filters
+static void __not_in_flash_func(filterGyro)() {
 	gyroGetData(bmiDataRaw);
 	for (int i = 0; i < 3; i++) {
 		gyroData[i].setRaw((i32)gyroDataRaw[i] * 4000); // gyro data in range of -.5 ... +.5 due to fixed point math,gyro data in range of -2000 ... +2000 (degrees per second)
 	}
 	gyroData[AXIS_PITCH] = -gyroData[AXIS_PITCH];
 	gyroData[AXIS_YAW] = -gyroData[AXIS_YAW];
-	duration = taskTimerGyro;
-	tasks[TASK_GYROREAD].totalDuration += duration;
-	if (duration > tasks[TASK_GYROREAD].maxDuration)
-		tasks[TASK_GYROREAD].maxDuration = duration;
-	if (duration < tasks[TASK_GYROREAD].minDuration)
-		tasks[TASK_GYROREAD].minDuration = duration;
-	taskTimerGyro = 0;
+	rpmFilterApply(gyroData);
+	dynNotchPush(gyroData);
+	dynNotchApply(gyroData);
+	gyroFilter.update(gyroData);
+}
 
-	updateAttitude();
-	duration = taskTimerPid;
-	if (tasks[TASK_PID_MOTORS].maxGap < duration)
-		tasks[TASK_PID_MOTORS].maxGap = duration;
-	taskTimerPid = 0;
-	tasks[TASK_PID_MOTORS].runCounter++;
+void pidLoop() {
+	{
+		TASK_PROBE(TASK_GYROREAD);
+		// samples that queued up during a stall keep the filters and the attitude continuous, the PID runs on the newest
+		while (gyroSamplesQueued() > 1) {
+			filterGyro();
+			updateFromGyro();
+		}
+		filterGyro();
+	}
 
-	decodeErpm();
+	updateAttitude();
+	TASK_PROBE(TASK_PID_MOTORS);
 
 	if (armed) {
 		// Quad armed
 		static u32 ffBufPos = 0;
 		static fix32 polynomials[5][3];
-		ELRS->getSmoothChannels(smoothChannels);
 		// calculate setpoints
 		polynomials[0][0] = (smoothChannels[0] - 1500) >> 9; //-1...+1
 		polynomials[0][1] = (smoothChannels[1] - 1500) >> 9;
@@ -167,7 +186,7 @@ void pidLoop() {
 				fix32 t = throttle - 512;
 				static PT1 vVelDFilter(15, 3200);
 				static PT1 vVelFFFilter(2, 3200);
-				static elapsedMillis setAltSetpointTimer;
+				static ElapsedLoopMillis setAltSetpointTimer;
 				static u32 stickWasCentered = 0;
 				// deadband in center of stick
 				if (t > 0) {
@@ -243,21 +262,23 @@ void pidLoop() {
 		pitchErrorSum = pitchErrorSum + pitchError;
 		yawErrorSum = yawErrorSum + yawError;
 
-		rollP = pidGains[0][P] * rollError;
-		pitchP = pidGains[1][P] * pitchError;
-		yawP = pidGains[2][P] * yawError;
-		rollI = pidGains[0][I] * rollErrorSum;
-		pitchI = pidGains[1][I] * pitchErrorSum;
-		yawI = pidGains[2][I] * yawErrorSum;
-		rollD = pidGains[0][D] * dFilterRoll.update(rollLast - gyroData[AXIS_ROLL]);
-		pitchD = pidGains[1][D] * dFilterPitch.update(pitchLast - gyroData[AXIS_PITCH]);
-		yawD = pidGains[2][D] * dFilterYaw.update(yawLast - gyroData[AXIS_YAW]);
-		rollFF = pidGains[0][FF] * (rollSetpoint - rollSetpoints[ffBufPos]);
-		pitchFF = pidGains[1][FF] * (pitchSetpoint - pitchSetpoints[ffBufPos]);
-		yawFF = pidGains[2][FF] * (yawSetpoint - yawSetpoints[ffBufPos]);
-		rollS = pidGains[0][S] * rollSetpoint;
-		pitchS = pidGains[1][S] * pitchSetpoint;
-		yawS = pidGains[2][S] * yawSetpoint;
+		rollP = pidGains[0][P].mulSat(rollError);
+		pitchP = pidGains[1][P].mulSat(pitchError);
+		yawP = pidGains[2][P].mulSat(yawError);
+		rollI = (rollErrorSum * pidGains[0][I]).getfix32Sat();
+		pitchI = (pitchErrorSum * pidGains[1][I]).getfix32Sat();
+		yawI = (yawErrorSum * pidGains[2][I]).getfix32Sat();
+		const fix32 dInput[3] = {rollLast - gyroData[AXIS_ROLL], pitchLast - gyroData[AXIS_PITCH], yawLast - gyroData[AXIS_YAW]};
+		dFilter.update(dInput);
+		rollD = pidGains[0][D].mulSat(dFilter[0]);
+		pitchD = pidGains[1][D].mulSat(dFilter[1]);
+		yawD = pidGains[2][D].mulSat(dFilter[2]);
+		rollFF = pidGains[0][FF].mulSat(rollSetpoint - rollSetpoints[ffBufPos]);
+		pitchFF = pidGains[1][FF].mulSat(pitchSetpoint - pitchSetpoints[ffBufPos]);
+		yawFF = pidGains[2][FF].mulSat(yawSetpoint - yawSetpoints[ffBufPos]);
+		rollS = pidGains[0][S].mulSat(rollSetpoint);
+		pitchS = pidGains[1][S].mulSat(pitchSetpoint);
+		yawS = pidGains[2][S].mulSat(yawSetpoint);
 
 		rollSetpoints[ffBufPos] = rollSetpoint;
 		pitchSetpoints[ffBufPos] = pitchSetpoint;
@@ -265,22 +286,22 @@ void pidLoop() {
 		ffBufPos++;
 		ffBufPos &= 7;
 
-		fix32 rollTerm = rollP + rollI + rollD + rollFF + rollS;
-		fix32 pitchTerm = pitchP + pitchI + pitchD + pitchFF + pitchS;
-		fix32 yawTerm = yawP + yawI + yawD + yawFF + yawS;
+		fix32 rollTerm = rollP.addSat(rollI).addSat(rollD).addSat(rollFF).addSat(rollS);
+		fix32 pitchTerm = pitchP.addSat(pitchI).addSat(pitchD).addSat(pitchFF).addSat(pitchS);
+		fix32 yawTerm = yawP.addSat(yawI).addSat(yawD).addSat(yawFF).addSat(yawS);
 		// scale throttle from 0...1024 to IDLE_PERMILLE*2...2000 (DShot output is 0...2000)
 		throttle *= THROTTLE_SCALE; // 0...1024 => 0...2000-IDLE_PERMILLE*2
 		throttle += IDLE_PERMILLE * 2; // 0...2000-IDLE_PERMILLE*2 => IDLE_PERMILLE*2...2000
 #ifdef PROPS_OUT
-		tRR = throttle - rollTerm + pitchTerm + yawTerm;
-		tFR = throttle - rollTerm - pitchTerm - yawTerm;
-		tRL = throttle + rollTerm + pitchTerm - yawTerm;
-		tFL = throttle + rollTerm - pitchTerm + yawTerm;
+		tRR = throttle.subSat(rollTerm).addSat(pitchTerm).addSat(yawTerm);
+		tFR = throttle.subSat(rollTerm).subSat(pitchTerm).subSat(yawTerm);
+		tRL = throttle.addSat(rollTerm).addSat(pitchTerm).subSat(yawTerm);
+		tFL = throttle.addSat(rollTerm).subSat(pitchTerm).addSat(yawTerm);
 #else
-		tRR = throttle - rollTerm + pitchTerm - yawTerm;
-		tFR = throttle - rollTerm - pitchTerm + yawTerm;
-		tRL = throttle + rollTerm + pitchTerm + yawTerm;
-		tFL = throttle + rollTerm - pitchTerm - yawTerm;
+		tRR = throttle.subSat(rollTerm).addSat(pitchTerm).subSat(yawTerm);
+		tFR = throttle.subSat(rollTerm).subSat(pitchTerm).addSat(yawTerm);
+		tRL = throttle.addSat(rollTerm).addSat(pitchTerm).addSat(yawTerm);
+		tFL = throttle.addSat(rollTerm).subSat(pitchTerm).subSat(yawTerm);
 #endif
 		throttles[(u8)MOTOR::RR] = tRR.geti32();
 		throttles[(u8)MOTOR::RL] = tRL.geti32();
@@ -361,7 +382,7 @@ void pidLoop() {
 		if (ELRS->channels[9] < 1500) {
 			sendThrottles(throttles);
 		} else {
-			static elapsedMillis motorBeepTimer = 0;
+			static ElapsedLoopMillis motorBeepTimer = 0;
 			if (motorBeepTimer > 500)
 				motorBeepTimer = 0;
 			if (motorBeepTimer < 50) {
@@ -380,13 +401,4 @@ void pidLoop() {
 		yawLast = 0;
 		takeoffCounter = 0;
 	}
-	duration = taskTimerPid;
-	tasks[TASK_PID_MOTORS].totalDuration += duration;
-	if (duration < tasks[TASK_PID_MOTORS].minDuration) {
-		tasks[TASK_PID_MOTORS].minDuration = duration;
-	}
-	if (duration > tasks[TASK_PID_MOTORS].maxDuration) {
-		tasks[TASK_PID_MOTORS].maxDuration = duration;
-	}
-	taskTimerPid = 0;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include "utils/filters.h"
 #include "utils/fixedPointInt.h"
 #include <Arduino.h>
 #define IDLE_PERMILLE 25
@@ -12,10 +13,18 @@
 #define FF_SHIFT 13
 #define S_SHIFT 8 // setpoint follow
 
+// dynamic low pass cutoffs (Hz), from the minimum at idle to the maximum at full throttle
+#define GYRO_LPF_MIN 250
+#define GYRO_LPF_MAX 500
+#define DTERM_LPF_MIN 100
+#define DTERM_LPF_MAX 200
+
 extern i16 bmiDataRaw[6]; // raw data from the BMI160 after calibration
 extern i16 *gyroDataRaw; // raw gyro data from the BMI160 after calibration, part of bmiDataRaw
 extern i16 *accelDataRaw; // raw accelerometer data from the BMI160 after calibration, part of bmiDataRaw
 extern fix32 gyroData[3]; // gyro data in deg/s
+extern BiquadN<3> gyroFilter; // dynamic low pass filters for the gyro data
+extern PT1N<3> dFilter; // dynamic low pass filters for the D term, roll, pitch, yaw
 extern fix32 rateFactors[5][3]; // rate factors for the PID controller, 0 = x^1, 1 = x^2... (x normalized to +-1 at full deflection)
 enum {
 	P,
@@ -53,9 +62,16 @@ enum class FlightMode {
 extern FlightMode flightMode; // currently selected flight mode (NOT whether the drone is armed)
 
 /**
- * @brief PID controller loop
+ * @brief first stage of the PID loop, everything that does not need the new gyro sample
+ *
+ * @details Runs while the DMA read of the sample is still in flight, so the SPI transfer is off the critical path: 1. decode ERPM, 2. update the RPM filter and dynamic notch coefficients, 3. update the throttle dependent low pass cutoffs, 4. smooth the RC channels
+ */
+void pidPrepare();
+
+/**
+ * @brief PID controller loop, call pidPrepare before
  *
- * @details 1. read the gyro data and convert to deg/s, 2. update attitude, 3. decode ERPM, 4. run pid controllers for the selected mode, 5. air mode, 6. send motor values, 7. blackbox logging
+ * @details 1. read the gyro data and convert to deg/s, 2. update attitude, 3. run pid controllers for the selected mode, 4. air mode, 5. send motor values, 6. blackbox logging
  */
 void pidLoop();
 
@@ -0,0 +1,72 @@
+#include "global.h"
+
+RpmNotchBank rpmNotches;
+fix32 rpmFilterMotorFreq[4];
+
+static PT1 motorFreqFilter[4] = {
+	PT1(RPM_FILTER_FREQ_CUTOFF, 3200),
+	PT1(RPM_FILTER_FREQ_CUTOFF, 3200),
+	PT1(RPM_FILTER_FREQ_CUTOFF, 3200),
+	PT1(RPM_FILTER_FREQ_CUTOFF, 3200),
+};
+static u32 nextMotor = 0;
+
+void initRpmFilter() {
+	rpmNotches = RpmNotchBank();
+	for (int m = 0; m < 4; m++) {
+		motorFreqFilter[m] = PT1(RPM_FILTER_FREQ_CUTOFF, 3200);
+		rpmFilterMotorFreq[m] = 0;
+	}
+	nextMotor = 0;
+}
+
+/// @brief updates the coefficients of one notch, enables or disables it
+static void __not_in_flash_func(updateNotch)(u32 n, fix32 freq) {
+	const u32 bit = 1 << n;
+	if (freq < RPM_FILTER_MIN_FREQ || freq > RPM_FILTER_MAX_FREQ) {
+		rpmNotches.active &= ~bit;
+		return;
+	}
+	notchCoeffsFix(freq, RPM_FILTER_Q, 3200, rpmNotches.b0[n], rpmNotches.a1[n], rpmNotches.a2[n]);
+	if (!(rpmNotches.active & bit)) {
+		// start from the current signal level instead of 0, to avoid a step when the notch is switched on
+		for (int ax = 0; ax < 3; ax++) {
+			rpmNotches.x1[ax][n] = gyroData[ax];
+			rpmNotches.x2[ax][n] = gyroData[ax];
+			rpmNotches.y1[ax][n] = gyroData[ax];
+			rpmNotches.y2[ax][n] = gyroData[ax];
+		}
+		rpmNotches.active |= bit;
+	}
+}
+
+void __not_in_flash_func(rpmFilterUpdate)() {
+	for (int m = 0; m < 4; m++) {
+		if (escErpmFail & (1 << m) || !escRpm[m]) {
+			rpmFilterMotorFreq[m] = 0;
+			continue;
+		}
+		rpmFilterMotorFreq[m] = motorFreqFilter[m].update(fix32().setRaw((escRpm[m] << 14) / 15)); // rpm / 60, without the fix32 range limit
+	}
+
+	// coefficients of one motor per loop
+	const u32 m = nextMotor;
+	nextMotor = (nextMotor + 1) & 3;
+	startFixTrig();
+	for (int h = 0; h < RPM_FILTER_HARMONICS; h++)
+		updateNotch(h * 4 + m, rpmFilterMotorFreq[m] * (h + 1));
+}
+
+void __not_in_flash_func(rpmFilterApply)(fix32 data[3]) {
+	const u32 active = rpmNotches.active;
+	if (!active) return;
+	for (int ax = 0; ax < 3; ax++) {
+		fix32 x = data[ax];
+		fix32 *x1 = rpmNotches.x1[ax], *x2 = rpmNotches.x2[ax], *y1 = rpmNotches.y1[ax], *y2 = rpmNotches.y2[ax];
+		for (u32 n = 0; n < RPM_FILTER_NOTCHES; n++) {
+			if (active & (1 << n))
+				x = notchStep(x, rpmNotches.b0[n], rpmNotches.a1[n], rpmNotches.a2[n], x1[n], x2[n], y1[n], y2[n]);
+		}
+		data[ax] = x;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "typedefs.h"
+#include "utils/fixedPointInt.h"
+
+/*
+ * RPM filter
+ *
+ * A bank of notch filters on the gyro data that follow the motor frequencies from the bidirectional DShot telemetry:
+ * RPM_FILTER_HARMONICS harmonics x 4 motors, each applied to all 3 axes.
+ * The coefficients are stored as struct of arrays and shared by the axes (a notch has b0 = b2 and b1 = a1, so 3 per notch).
+ * They are calculated with the fixed point trig functions, for one motor per loop iteration (every notch is updated at
+ * 800 Hz), in pidPrepare while the gyro is read. The motor frequencies are smoothed every loop.
+ */
+
+#define RPM_FILTER_HARMONICS 3
+#define RPM_FILTER_NOTCHES (RPM_FILTER_HARMONICS * 4)
+#define RPM_FILTER_MIN_FREQ 80 // Hz, below that (and for motors without telemetry) the notches are disabled
+#define RPM_FILTER_MAX_FREQ 1400 // Hz, harmonics above that (close to the Nyquist frequency) are disabled
+#define RPM_FILTER_Q 5 // center frequency / bandwidth
+#define RPM_FILTER_FREQ_CUTOFF 150 // Hz, PT1 cutoff of the motor frequency tracking
+
+typedef struct rpmNotchBank {
+	// coefficients per notch (index harmonic * 4 + motor), 2.30 fixed point
+	i32 b0[RPM_FILTER_NOTCHES]; // = b2
+	i32 a1[RPM_FILTER_NOTCHES]; // = b1
+	i32 a2[RPM_FILTER_NOTCHES];
+	u16 active; // bit per notch
+	// states per axis and notch
+	fix32 x1[3][RPM_FILTER_NOTCHES];
+	fix32 x2[3][RPM_FILTER_NOTCHES];
+	fix32 y1[3][RPM_FILTER_NOTCHES];
+	fix32 y2[3][RPM_FILTER_NOTCHES];
+} RpmNotchBank;
+
+extern RpmNotchBank rpmNotches;
+extern fix32 rpmFilterMotorFreq[4]; // smoothed motor frequency in Hz, 0 if the motor has no valid telemetry
+
+/// @brief resets the notch bank and disables all notches
+void initRpmFilter();
+
+/**
+ * @brief tracks the motor frequencies and updates the coefficients of one motor's notches
+ * @details independent of the gyro sample, called in pidPrepare after decodeErpm
+ */
+void rpmFilterUpdate();
+
+/**
+ * @brief filters the gyro data with all active notches
+ * @param data gyro data of the 3 axes, filtered in place
+ */
+void rpmFilterApply(fix32 data[3]);
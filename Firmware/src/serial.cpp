@@ -1,33 +1,36 @@
 #include "global.h"
 
 u8 readChar = 0;
-u32 crcLutD5[256] = {0};
-Stream *serials[3] = {
-	&Serial,
-	&Serial1,
-	&Serial2};
 
-u32 serialFunctions[3] = {
-	SERIAL_MSP,
-	SERIAL_CRSF,
-	SERIAL_GPS};
-
-void initSerial() {
+static constexpr CrcLut makeCrcLut(const u8 poly) {
+	CrcLut lut = {};
 	for (u32 i = 0; i < 256; i++) {
 		u32 crc = i;
 		for (u32 j = 0; j < 8; j++) {
 			if (crc & 0x80)
-				crc = (crc << 1) ^ 0xD5;
+				crc = (crc << 1) ^ poly;
 			else
 				crc <<= 1;
 		}
-		crcLutD5[i] = crc & 0xFF;
+		lut.v[i] = crc & 0xFF;
 	}
+	return lut;
 }
+// in RAM, it is used for every received CRSF byte
+constexpr CrcLut crcLutD5 __not_in_flash("crcLut") = makeCrcLut(0xD5);
+static_assert(crcLutD5[1] == 0xD5, "CRC8 D5 table");
+
+Stream *serials[3] = {
+	&Serial,
+	&Serial1,
+	&Serial2};
+
+u32 serialFunctions[3] = {
+	SERIAL_MSP,
+	SERIAL_CRSF,
+	SERIAL_GPS};
 
 void serialLoop() {
-	elapsedMicros taskTimer = 0;
-	tasks[TASK_SERIAL].runCounter++;
 	for (int i = 0; i < 3; i++) {
 		if (serialFunctions[i] & SERIAL_DISABLED)
 			continue;
@@ -41,9 +44,7 @@ void serialLoop() {
 			}
 			if (serialFunctions[i] & SERIAL_MSP) {
 				rp2040.wdt_reset();
-				elapsedMicros timer = 0;
 				mspHandleByte(readChar, i);
-				taskTimer -= timer;
 			}
 			if (serialFunctions[i] & SERIAL_GPS) {
 				if (!gpsBuffer.isFull())
@@ -60,12 +61,4 @@ void serialLoop() {
 			}
 		}
 	}
-	u32 duration = taskTimer;
-	tasks[TASK_SERIAL].totalDuration += duration;
-	if (duration < tasks[TASK_SERIAL].minDuration) {
-		tasks[TASK_SERIAL].minDuration = duration;
-	}
-	if (duration > tasks[TASK_SERIAL].maxDuration) {
-		tasks[TASK_SERIAL].maxDuration = duration;
-	}
 }
\ No newline at end of file
@@ -17,11 +17,15 @@ extern u32 serialFunctions[3];
 // 0 = Serial (USB CDC), 1 = Serial1 = UART0, 2 = Serial2 = UART1
 extern Stream *serials[3];
 
-extern u32 crcLutD5[256]; // u32 is used because it is faster than u8
+/// @brief CRC8 lookup table, a struct instead of an array so that a constexpr function can generate it
+typedef struct crcLut {
+	u8 v[256];
+	inline constexpr u8 operator[](const u32 i) const {
+		return v[i];
+	};
+} CrcLut;
+extern const CrcLut crcLutD5; // CRC8 with the polynomial 0xD5 (CRSF, MSP v2), generated at compile time
 #define CRC_LUT_D5_APPLY(crc, data) crc = crcLutD5[((crc) ^ (data)) & 0xFF]
 
-/// @brief fills crcLutD5
-void initSerial();
-
 /// @brief reads the serial port and sends it to the appropriate handler
 void serialLoop();
\ No newline at end of file
@@ -34,7 +34,6 @@ ExpressLRS::~ExpressLRS() {
 }
 
 void ExpressLRS::loop() {
-	elapsedMicros taskTimer;
 	if (frequencyTimer >= 1000) {
 		if (rcPacketRateCounter > 20 && rcMsgCount > 300)
 			isLinkUp = true;
@@ -161,7 +160,6 @@ void ExpressLRS::loop() {
 		if (currentTelemSensor > 5) currentTelemSensor = 0;
 		return;
 	}
-	taskTimer = 0;
 	if (maxScan > 10) maxScan = 10;
 	if (msgBufIndex > 54) maxScan = 64 - msgBufIndex;
 	for (int i = 0; i < maxScan; i++) {
@@ -186,14 +184,6 @@ void ExpressLRS::loop() {
 	if (msgBufIndex >= 2 + msgBuffer[1]) {
 		processMessage();
 	}
-	u32 duration = taskTimer;
-	tasks[TASK_ELRS].totalDuration += duration;
-	if (duration < tasks[TASK_ELRS].minDuration) {
-		tasks[TASK_ELRS].minDuration = duration;
-	}
-	if (duration > tasks[TASK_ELRS].maxDuration) {
-		tasks[TASK_ELRS].maxDuration = duration;
-	}
 }
 
 void ExpressLRS::processMessage() {
@@ -216,7 +206,6 @@ void ExpressLRS::processMessage() {
 	msgCount++;
 	sinceLastMessage = 0;
 	packetRateCounter++;
-	tasks[TASK_ELRS].runCounter++;
 
 	switch (msgBuffer[2]) {
 	case FRAMETYPE_RC_CHANNELS_PACKED: {
@@ -34,8 +34,8 @@ public:
 	 * @param smoothChannels Array to store the smoothed channels
 	 */
 	void getSmoothChannels(fix32 smoothChannels[4]);
-	elapsedMicros sinceLastRCMessage; // time (µs) since the last valid RC message was received
-	elapsedMicros sinceLastMessage; // time (µs) since the last valid message was received
+	ElapsedLoopMicros sinceLastRCMessage; // time (µs) since the last valid RC message was received
+	ElapsedLoopMicros sinceLastMessage; // time (µs) since the last valid message was received
 	bool isLinkUp = false; // true if the link is up (300 RC messages received and 20 in the last second)
 	bool isReceiverUp = false; // true if the receiver recognized (1 message in the last second)
 	u32 msgCount = 0; // total count of any received message
@@ -117,9 +117,9 @@ private:
 	const u8 pinTX;
 	const u8 pinRX;
 	const u32 baudrate;
-	elapsedMillis frequencyTimer;
-	elapsedMillis telemetryTimer;
-	elapsedMillis heartbeatTimer;
+	ElapsedLoopMillis frequencyTimer;
+	ElapsedLoopMillis telemetryTimer;
+	ElapsedLoopMillis heartbeatTimer;
 	u32 rcPacketRateCounter = 0;
 	u32 packetRateCounter = 0;
 	u32 crc = 0;
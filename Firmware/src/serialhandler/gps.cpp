@@ -1,7 +1,7 @@
 #include "global.h"
 
 RingBuffer<u8> gpsBuffer(1024);
-elapsedMillis gpsInitTimer;
+ElapsedLoopMillis gpsInitTimer;
 bool gpsInitAck = false;
 GpsAccuracy gpsAcc;
 datetime_t gpsTime;
@@ -45,7 +45,7 @@ void initGPS() {
 
 int gpsSerialSpeed = 38400;
 u8 retryCounter = 0;
-elapsedMillis lastPvtMessage = 0;
+ElapsedLoopMillis lastPvtMessage = 0;
 
 void fillOpenLocationCode() {
 	u32 lat = gpsMotion.lat / 1250 + 720000;
@@ -163,7 +163,6 @@ void gpsLoop() {
 		}
 	}
 	if (gpsBuffer.itemCount() >= 8) {
-		elapsedMicros taskTimer = 0;
 		int len = gpsBuffer[4] + gpsBuffer[5] * 256;
 		if (gpsBuffer[0] != UBX_SYNC1 || gpsBuffer[1] != UBX_SYNC2) {
 			gpsBuffer.pop();
@@ -176,7 +175,6 @@ void gpsLoop() {
 		if (gpsBuffer.itemCount() < len + 8) {
 			return;
 		}
-		tasks[TASK_GPS].runCounter++;
 		u8 ck_a, ck_b;
 		gpsChecksum(&(gpsBuffer[2]), len + 4, &ck_a, &ck_b);
 		if (ck_a != gpsBuffer[len + 6] || ck_b != gpsBuffer[len + 7]) {
@@ -291,13 +289,5 @@ void gpsLoop() {
 		}
 		// pop the packet
 		gpsBuffer.erase(len + 8);
-		u32 duration = taskTimer;
-		tasks[TASK_GPS].totalDuration += duration;
-		if (duration < tasks[TASK_GPS].minDuration) {
-			tasks[TASK_GPS].minDuration = duration;
-		}
-		if (duration > tasks[TASK_GPS].maxDuration) {
-			tasks[TASK_GPS].maxDuration = duration;
-		}
 	}
 }
\ No newline at end of file
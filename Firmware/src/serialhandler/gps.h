@@ -5,7 +5,7 @@ using std::vector;
 #define GPS_BUF_LEN 1024
 
 extern RingBuffer<u8> gpsBuffer; // GPS incoming serial buffer
-extern elapsedMillis lastPvtMessage; // time since the last PVT (position velocity time) message was received
+extern ElapsedLoopMillis lastPvtMessage; // time since the last PVT (position velocity time) message was received
 extern u8 currentPvtMsg[92];
 extern u32 newPvtMessageFlag;
 
@@ -5,12 +5,12 @@
 
 u8 accelCalDone = 0;
 
-elapsedMillis mspOverrideMotors = 1001;
+ElapsedLoopMillis mspOverrideMotors = 1001;
 
 static const char targetIdentifier[] = "KD04";
 static const char targetFullName[] = "Kolibri Dev v0.4";
 
-elapsedMillis lastConfigPingRx = 0;
+ElapsedLoopMillis lastConfigPingRx = 0;
 bool configuratorConnected = false;
 
 u8 lastMspSerial = 0;
@@ -709,21 +709,98 @@ void processMspCmd(u8 serialNum, MspMsgType mspType, MspFn fn, MspVersion versio
 		case MspFn::TASK_STATUS: {
 			u32 buf[256];
 			for (int i = 0; i < 32; i++) {
+				TaskSnapshot snapshot;
+				readTaskStats(i, snapshot);
 				buf[i * 8 + 0] = tasks[i].debugInfo;
-				buf[i * 8 + 1] = tasks[i].minDuration;
-				buf[i * 8 + 2] = tasks[i].maxDuration;
+				buf[i * 8 + 1] = snapshot.minDuration == 0xFFFFFFFF ? 0xFFFFFFFF : cyclesToNs(snapshot.minDuration);
+				buf[i * 8 + 2] = cyclesToNs(snapshot.maxDuration);
 				buf[i * 8 + 3] = tasks[i].frequency;
-				buf[i * 8 + 4] = tasks[i].avgDuration;
+				buf[i * 8 + 4] = cyclesToNs(tasks[i].avgDuration);
 				buf[i * 8 + 5] = tasks[i].errorCount;
 				buf[i * 8 + 6] = tasks[i].lastError;
-				buf[i * 8 + 7] = tasks[i].maxGap;
+				buf[i * 8 + 7] = cyclesToUs(snapshot.maxGap);
 			}
 			sendMsp(serialNum, MspMsgType::RESPONSE, fn, version, (char *)buf, sizeof(buf));
+			newTaskStatsWindow();
+		} break;
+		case MspFn::TASK_LATENCY: {
+			// per task: duration p50, p99, p99.9 in ns, gap p50, p99, p99.9 in µs (0 = no data or no consistent copy, 0xFFFFFFFF = out of range)
+			static const u32 percentiles[3] = {500, 990, 999};
+			static TaskHistogram hist;
+			u32 buf[32 * 6];
 			for (int i = 0; i < 32; i++) {
-				tasks[i].minDuration = 0xFFFFFFFF;
-				tasks[i].maxDuration = 0;
-				tasks[i].maxGap = 0;
+				readTaskHistogram(i, hist); // cleared if it could not be copied
+				for (int p = 0; p < 3; p++) {
+					u32 d = taskHistPercentile(hist.duration, percentiles[p]);
+					u32 g = taskHistPercentile(hist.gap, percentiles[p]);
+					buf[i * 6 + p] = d == 0xFFFFFFFF ? d : cyclesToNs(d);
+					buf[i * 6 + 3 + p] = g == 0xFFFFFFFF ? g : cyclesToUs(g);
+				}
+			}
+			sendMsp(serialNum, MspMsgType::RESPONSE, fn, version, (char *)buf, sizeof(buf));
+			resetTaskHistograms();
+		} break;
+		case MspFn::TRACE_START:
+			traceStart();
+			sendMsp(serialNum, MspMsgType::RESPONSE, fn, version);
+			break;
+		case MspFn::GET_TRACE: {
+			// request: core, first event (u16). response: core, state, first event (u16), event count of the core (u16), events in this response (u16), sync cycles, sync µs, F_CPU, events
+			if (reqLen < 3 || reqPayload[0] > 1) {
+				sendMsp(serialNum, MspMsgType::ERROR, fn, version);
+				break;
 			}
+			const u8 core = reqPayload[0];
+			const TraceBuffer &t = traceBuffers[core];
+			const u16 first = DECODE_U2((u8 *)&reqPayload[1]);
+			const u16 count = t.count;
+			u16 n = first < count ? count - first : 0;
+			if (n > 128) n = 128;
+			static u8 traceBuf[20 + 128 * sizeof(TraceEvent)];
+			traceBuf[0] = core;
+			traceBuf[1] = t.state;
+			traceBuf[2] = first & 0xFF;
+			traceBuf[3] = first >> 8;
+			traceBuf[4] = count & 0xFF;
+			traceBuf[5] = count >> 8;
+			traceBuf[6] = n & 0xFF;
+			traceBuf[7] = n >> 8;
+			memcpy(&traceBuf[8], &t.syncCycles, 4);
+			memcpy(&traceBuf[12], &t.syncUs, 4);
+			const u32 fCpu = F_CPU;
+			memcpy(&traceBuf[16], &fCpu, 4);
+			if (n) memcpy(&traceBuf[20], &t.events[first], n * sizeof(TraceEvent));
+			sendMsp(serialNum, MspMsgType::RESPONSE, fn, version, (char *)traceBuf, 20 + n * sizeof(TraceEvent));
+		} break;
+		case MspFn::BENCHMARK: {
+			// request: core (optional, default 0)
+			// response: F_CPU, core, benchmark count (u8), per benchmark: cycles of all iterations, iterations (u16), name length (u8), name
+			const u8 core = reqLen ? reqPayload[0] : 0;
+			if (armed || core > 1) {
+				sendMsp(serialNum, MspMsgType::ERROR, fn, version);
+				break;
+			}
+			static BenchmarkResult results[BENCHMARK_MAX_COUNT];
+			static char benchBuf[6 + BENCHMARK_MAX_COUNT * 40];
+			if (!runBenchmarksOnCore(core, results)) {
+				sendMsp(serialNum, MspMsgType::ERROR, fn, version);
+				break;
+			}
+			const u32 fCpu = F_CPU;
+			memcpy(benchBuf, &fCpu, 4);
+			benchBuf[4] = core;
+			benchBuf[5] = benchmarkCount;
+			u32 len = 6;
+			for (u32 i = 0; i < benchmarkCount; i++) {
+				u32 nameLen = strlen(benchmarks[i].name);
+				if (nameLen > 33) nameLen = 33;
+				memcpy(&benchBuf[len], &results[i].cycles, 4);
+				memcpy(&benchBuf[len + 4], &results[i].iterations, 2);
+				benchBuf[len + 6] = nameLen;
+				memcpy(&benchBuf[len + 7], benchmarks[i].name, nameLen);
+				len += 7 + nameLen;
+			}
+			sendMsp(serialNum, MspMsgType::RESPONSE, fn, version, benchBuf, len);
 		} break;
 		case MspFn::GET_RX_STATUS: {
 			buf[0] = ELRS->isReceiverUp;
@@ -833,7 +910,7 @@ void processMspCmd(u8 serialNum, MspMsgType mspType, MspFn fn, MspVersion versio
 }
 
 void mspHandleByte(u8 c, u8 serialNum) {
-	elapsedMicros taskTimer = 0;
+	TASK_PROBE_START(taskStart);
 	static char payloadBuf[2052] = {0}; // worst case: 2048 bytes payload + 3 bytes checksum (v2 over v1 jumbo) + 1 byte start. After the start byte, the index is reset to 0
 	static u16 payloadBufIndex = 0;
 	static u16 payloadLen = 0;
@@ -845,7 +922,6 @@ void mspHandleByte(u8 c, u8 serialNum) {
 	static MspVersion msgMspVer = MspVersion::V2;
 	static MspState mspState = MspState::IDLE;
 
-	tasks[TASK_CONFIGURATOR].runCounter++;
 	payloadBuf[payloadBufIndex++] = c;
 
 	switch (mspState) {
@@ -1040,13 +1116,6 @@ void mspHandleByte(u8 c, u8 serialNum) {
 		mspState = MspState::IDLE;
 		break;
 	}
-	u32 duration = taskTimer;
-	tasks[TASK_CONFIGURATOR].totalDuration += duration;
-	if (duration < tasks[TASK_CONFIGURATOR].minDuration) {
-		tasks[TASK_CONFIGURATOR].minDuration = duration;
-	}
-	if (duration > tasks[TASK_CONFIGURATOR].maxDuration) {
-		tasks[TASK_CONFIGURATOR].maxDuration = duration;
+	if (TASK_PROBE_END(TASK_CONFIGURATOR, taskStart))
 		tasks[TASK_CONFIGURATOR].debugInfo = (u32)fn;
-	}
 }
\ No newline at end of file
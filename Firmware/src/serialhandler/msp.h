@@ -111,6 +111,10 @@ enum class MspFn {
 
 	// 0x417_ Task Manager
 	TASK_STATUS = 0x4170,
+	TASK_LATENCY = 0x4171,
+	TRACE_START = 0x4172,
+	GET_TRACE = 0x4173,
+	BENCHMARK = 0x4174,
 
 	// 0x418_ Receiver
 	GET_RX_STATUS = 0x4180,
@@ -232,7 +236,7 @@ void mspHandleByte(u8 c, u8 serialNum);
 
 /// @brief counter for the motor override timeout
 /// @details If the configurator is connected, it can override the motor values when this is < 1000, and it is possible to arm with an attached configurator
-extern elapsedMillis mspOverrideMotors;
+extern ElapsedLoopMillis mspOverrideMotors;
 
 /// @brief handles configurator pings and asynchronous operations
 void configuratorLoop();
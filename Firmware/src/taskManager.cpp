@@ -1,43 +1,236 @@
 #include "global.h"
 __attribute__((__aligned__(4))) volatile FCTask tasks[32];
-
-elapsedMillis taskManagerTimer;
+volatile TaskBank taskBanks[2][32];
+TaskHistogram taskHistograms[32];
+volatile u32 taskStatsWindow = 0, taskHistWindow = 0; // incremented by the readers, applied by the owning cores
 
 void resetTasks() {
 	for (int i = 0; i < 32; i++) {
-		tasks[i].runCounter = 0;
-		tasks[i].minDuration = 0xFFFFFFFF;
-		tasks[i].maxDuration = 0;
 		tasks[i].frequency = 0;
 		tasks[i].avgDuration = 0;
+		for (int c = 0; c < 2; c++) {
+			volatile TaskBank &b = taskBanks[c][i];
+			b.seq = 0;
+			b.runCounter = 0;
+			b.totalDuration = 0;
+			b.minDuration = 0xFFFFFFFF;
+			b.maxDuration = 0;
+			b.maxGap = 0;
+			b.lastEnd = 0;
+			b.window = 0;
+			b.histWindow = 0;
+		}
+	}
+}
+
+u32 __not_in_flash_func(taskHistBucket)(u32 cycles) {
+	if (cycles < (1 << TASK_HIST_MIN_OCTAVE)) return 0;
+	const u32 octave = 31 - __builtin_clz(cycles);
+	const u32 sub = (cycles >> (octave - TASK_HIST_SUB_BITS)) & ((1 << TASK_HIST_SUB_BITS) - 1);
+	const u32 bucket = ((octave - TASK_HIST_MIN_OCTAVE) << TASK_HIST_SUB_BITS) + sub;
+	return bucket < TASK_HIST_BUCKETS ? bucket : TASK_HIST_BUCKETS - 1;
+}
+
+static inline void histAdd(u16 *hist, u32 cycles) {
+	u16 &b = hist[taskHistBucket(cycles)];
+	if (b == 0xFFFF) {
+		for (int i = 0; i < TASK_HIST_BUCKETS; i++)
+			hist[i] >>= 1;
+	}
+	b++;
+}
+
+u32 taskHistPercentile(const u16 *hist, u32 perMille) {
+	u32 total = 0;
+	for (int i = 0; i < TASK_HIST_BUCKETS; i++)
+		total += hist[i];
+	if (!total) return 0;
+	const u32 target = ((u64)total * perMille + 999) / 1000; // number of samples at or below the percentile
+	u32 count = 0;
+	for (int i = 0; i < TASK_HIST_BUCKETS - 1; i++) {
+		count += hist[i];
+		if (count >= target) {
+			// upper bound of bucket i
+			const u32 octave = (i >> TASK_HIST_SUB_BITS) + TASK_HIST_MIN_OCTAVE;
+			const u32 sub = i & ((1 << TASK_HIST_SUB_BITS) - 1);
+			return ((1 << TASK_HIST_SUB_BITS) + sub + 1) << (octave - TASK_HIST_SUB_BITS);
+		}
+	}
+	return 0xFFFFFFFF;
+}
+
+void resetTaskHistograms() {
+	taskHistWindow = taskHistWindow + 1;
+}
+
+void newTaskStatsWindow() {
+	taskStatsWindow = taskStatsWindow + 1;
+}
+
+bool __not_in_flash_func(recordTaskRun)(u8 taskId, u32 start, u32 end) {
+	const u32 core = get_core_num();
+	if (traceBuffers[core].state != TRACE_IDLE)
+		traceRecord(core, taskId, start, end);
+	// volatile accesses keep the compiler from merging or moving the seq updates, the barriers order them for the other core
+	volatile TaskBank &b = taskBanks[core][taskId];
+	const u32 duration = end - start;
+	bool newMax = false;
+	b.seq++;
+	__dmb();
+	const u32 window = taskStatsWindow;
+	if (b.window != window) {
+		b.window = window;
+		b.minDuration = 0xFFFFFFFF;
+		b.maxDuration = 0;
+		b.maxGap = 0;
+	}
+	TaskHistogram &h = taskHistograms[taskId];
+	const u32 histWindow = taskHistWindow;
+	if (b.histWindow != histWindow) {
+		b.histWindow = histWindow;
+		memset(&h, 0, sizeof(h));
+	}
+	b.runCounter++;
+	b.totalDuration += duration;
+	if (duration < b.minDuration)
+		b.minDuration = duration;
+	if (duration > b.maxDuration) {
+		b.maxDuration = duration;
+		newMax = true;
+	}
+	histAdd(h.duration, duration);
+	if (b.lastEnd) {
+		const u32 gap = start - b.lastEnd;
+		if (gap > b.maxGap)
+			b.maxGap = gap;
+		histAdd(h.gap, gap);
+	}
+	b.lastEnd = end;
+	__dmb();
+	b.seq++;
+	return newMax;
+}
+
+/// @brief copies a bank entry, returns false if the owning core updated it in the meantime
+static bool copyBank(volatile TaskBank &b, TaskBank &copy) {
+	const u32 seq = b.seq;
+	if (seq & 1) return false;
+	__dmb();
+	copy.runCounter = b.runCounter;
+	copy.totalDuration = b.totalDuration;
+	copy.minDuration = b.minDuration;
+	copy.maxDuration = b.maxDuration;
+	copy.maxGap = b.maxGap;
+	copy.window = b.window;
+	__dmb();
+	return seq == b.seq;
+}
+
+void readTaskStats(u8 taskId, TaskSnapshot &snapshot) {
+	snapshot.runCounter = 0;
+	snapshot.totalDuration = 0;
+	snapshot.minDuration = 0xFFFFFFFF;
+	snapshot.maxDuration = 0;
+	snapshot.maxGap = 0;
+	const u32 window = taskStatsWindow;
+	for (int c = 0; c < 2; c++) {
+		TaskBank copy;
+		while (!copyBank(taskBanks[c][taskId], copy)) {
+		}
+		snapshot.runCounter += copy.runCounter;
+		snapshot.totalDuration += copy.totalDuration;
+		if (copy.window != window) continue; // not run since the last window started
+		if (copy.minDuration < snapshot.minDuration)
+			snapshot.minDuration = copy.minDuration;
+		if (copy.maxDuration > snapshot.maxDuration)
+			snapshot.maxDuration = copy.maxDuration;
+		if (copy.maxGap > snapshot.maxGap)
+			snapshot.maxGap = copy.maxGap;
 	}
 }
 
+bool readTaskHistogram(u8 taskId, TaskHistogram &copy) {
+	const u32 window = taskHistWindow;
+	for (int retry = 0; retry < TASK_HIST_READ_RETRIES; retry++) {
+		const u32 seq0 = taskBanks[0][taskId].seq, seq1 = taskBanks[1][taskId].seq;
+		if ((seq0 | seq1) & 1) continue;
+		__dmb();
+		const bool current = taskBanks[0][taskId].histWindow == window || taskBanks[1][taskId].histWindow == window;
+		if (current)
+			memcpy(&copy, &taskHistograms[taskId], sizeof(copy));
+		else
+			memset(&copy, 0, sizeof(copy)); // cleared, but not run since then
+		__dmb();
+		if (seq0 == taskBanks[0][taskId].seq && seq1 == taskBanks[1][taskId].seq) return true;
+	}
+	// the task runs too often to get a copy between two runs, do not block the calling core
+	memset(&copy, 0, sizeof(copy));
+	return false;
+}
+
 void initTaskManager() {
 	resetTasks();
+	resetTaskHistograms();
 }
 void taskManagerLoop() {
-	elapsedMicros taskTimer = 0;
-	tasks[TASK_TASKMANAGER].runCounter++;
-	if (taskManagerTimer >= 1000) {
-		taskManagerTimer = 0;
-		for (int i = 0; i < 32; i++) {
-			tasks[i].frequency = tasks[i].runCounter;
-			if (tasks[i].runCounter > 0) {
-				tasks[i].avgDuration = tasks[i].totalDuration / tasks[i].runCounter;
-				tasks[i].totalDuration = 0;
-				tasks[i].runCounter = 0;
+	static u32 lastRuns[32] = {0}, lastTotal[32] = {0};
+	for (int i = 0; i < 32; i++) {
+		TaskSnapshot snapshot;
+		readTaskStats(i, snapshot);
+		const u32 runs = snapshot.runCounter - lastRuns[i];
+		tasks[i].frequency = runs;
+		if (runs > 0)
+			tasks[i].avgDuration = (snapshot.totalDuration - lastTotal[i]) / runs;
+		lastRuns[i] = snapshot.runCounter;
+		lastTotal[i] = snapshot.totalDuration;
+	}
+	tasks[TASK_MAGNETOMETER].debugInfo = magRunCounter;
+	magRunCounter = 0;
+}
+
+u32 schedulerPass = 0;
+void schedulerLoop(SchedulerTask *table, u32 count) {
+	schedulerPass++;
+	const u32 passStart = loopMicros();
+	while (true) {
+		updateLoopTime();
+		const u32 now = loopMicros();
+		SchedulerTask *next = nullptr;
+		u32 nextScore = 0;
+		for (u32 i = 0; i < count; i++) {
+			SchedulerTask &t = table[i];
+			if (!t.priority || t.lastPass == schedulerPass) continue;
+			const u32 age = now - t.lastStart;
+			if (age < t.period) continue;
+			if (t.ready && !t.ready()) continue;
+			const u32 overdue = (age - t.period) / (t.period + SCHEDULER_SLICE_US); // in periods
+			if (now - passStart + t.budget > SCHEDULER_SLICE_US && overdue < SCHEDULER_STARVED_FACTOR) {
+				// does not fit into this pass anymore, try again in the next one
+				t.deferCount++;
+				t.lastPass = schedulerPass;
+				continue;
+			}
+			const u32 score = t.priority * (1 + overdue);
+			if (score > nextScore) {
+				next = &t;
+				nextScore = score;
 			}
 		}
-		tasks[TASK_MAGNETOMETER].debugInfo = magRunCounter;
-		magRunCounter = 0;
-	}
-	u32 duration = taskTimer;
-	tasks[TASK_TASKMANAGER].totalDuration += duration;
-	if (duration < tasks[TASK_TASKMANAGER].minDuration) {
-		tasks[TASK_TASKMANAGER].minDuration = duration;
-	}
-	if (duration > tasks[TASK_TASKMANAGER].maxDuration) {
-		tasks[TASK_TASKMANAGER].maxDuration = duration;
+		if (!next) return;
+
+		SchedulerTask &t = *next;
+		if (t.lastEnd && now - t.lastStart - t.period > t.maxLatency)
+			t.maxLatency = now - t.lastStart - t.period;
+		t.lastPass = schedulerPass;
+		TASK_PROBE_START(taskStart);
+		t.run();
+		if (t.taskId != TASK_NONE)
+			TASK_PROBE_END(t.taskId, taskStart);
+		updateLoopTime();
+		const u32 end = loopMicros();
+		if (end - now > t.budget)
+			t.overrunCount++;
+		t.lastStart = now;
+		t.lastEnd = end;
 	}
 }
\ No newline at end of file
@@ -1,19 +1,49 @@
+#include "timebase.h"
 #include "typedefs.h"
 #include <Arduino.h>
 
 typedef struct task {
-	u32 runCounter; // incremented every time the task is run, reset every second
-	u32 minDuration; // minimum duration of the task
-	u32 maxDuration; // maximum duration of the task
 	u32 frequency; // how often the task is run in the last second
-	u32 avgDuration; // average duration of the task in the last second
+	u32 avgDuration; // average duration of the task in the last second in cycles
 	u32 errorCount; // how often the task has thrown an error since boot
 	u32 lastError; // last error code (different for each task)
-	u32 totalDuration; // total duration the task has taken since the reset every second
 	u32 debugInfo; // debug info (different for each task)
-	u32 maxGap; // maximum gap between two runs of the task (from end to start)
 } FCTask;
-extern volatile FCTask tasks[32]; // holds all the task stats
+extern volatile FCTask tasks[32]; // holds the published task stats and the error info
+
+/**
+ * @brief timing stats of the tasks that one core ran
+ * @details Only the core that owns the bank writes to it. Readers take a consistent copy with readTaskStats, which
+ * retries while seq is odd or changed during the copy (seqlock). The counters are never reset, so readers work with
+ * differences instead of clearing values under the feet of the other core.
+ */
+typedef struct taskBank {
+	u32 seq; // incremented before and after every update, odd while an update is in progress
+	u32 runCounter; // runs since boot
+	u32 totalDuration; // sum of all durations since boot in cycles, wraps around
+	u32 minDuration; // minimum duration in the current window in cycles
+	u32 maxDuration; // maximum duration in the current window in cycles
+	u32 maxGap; // maximum gap between two runs (from end to start) in the current window in cycles
+	u32 lastEnd; // cycle count at the end of the last run, 0 = not run yet
+	u32 window; // window the min/max values belong to, see newTaskStatsWindow
+	u32 histWindow; // window the histograms belong to, see resetTaskHistograms
+} TaskBank;
+extern volatile TaskBank taskBanks[2][32]; // one bank per core
+
+/// @brief consistent view of the timing of one task, combined over both cores
+typedef struct taskSnapshot {
+	u32 runCounter; // runs since boot
+	u32 totalDuration; // sum of all durations since boot in cycles, wraps around
+	u32 minDuration; // minimum duration since the last newTaskStatsWindow call in cycles, 0xFFFFFFFF if not run
+	u32 maxDuration; // maximum duration since the last newTaskStatsWindow call in cycles
+	u32 maxGap; // maximum gap since the last newTaskStatsWindow call in cycles
+} TaskSnapshot;
+
+/// @brief takes a tear-free snapshot of the timing of a task, can be called from either core
+void readTaskStats(u8 taskId, TaskSnapshot &snapshot);
+
+/// @brief starts a new window for the min/max durations and gaps, the owning cores reset them on their next update
+void newTaskStatsWindow();
 
 enum Tasks {
 	TASK_LOOP0,
@@ -28,6 +58,7 @@ enum Tasks {
 	TASK_GPS,
 	TASK_MAGNETOMETER,
 	TASK_TASKMANAGER,
+	TASK_DYN_NOTCH,
 	TASK_LOOP1,
 	TASK_GYROREAD,
 	TASK_IMU,
@@ -37,11 +68,132 @@ enum Tasks {
 	TASK_PID_MOTORS,
 	TASK_ESC_RPM,
 	TASK_OSD,
-	TASK_BAROREAD
+	TASK_BAROREAD,
+	TASK_GYRO_LATENCY // not a task, measures from the gyro INT1 edge to the DShot output
 };
 
 /// @brief resets all task stats
 void initTaskManager();
 
-/// @brief checks if a second has passed and updates the task stats
+#define TASK_HIST_SUB_BITS 2 // log2 of the number of buckets per octave
+#define TASK_HIST_MIN_OCTAVE 6 // first octave with its own buckets: 2^6 cycles = 0.24 µs, everything below lands in bucket 0
+#define TASK_HIST_BUCKETS 80 // 20 octaves up to 2^26 cycles = 254 ms, everything above lands in the last bucket
+
+/**
+ * @brief log-bucketed histograms of one task
+ * @details Each octave of cycles is split into 1 << TASK_HIST_SUB_BITS buckets, so the bucket bounds are accurate to 25%.
+ * Once a bucket would overflow, all buckets of that histogram are halved, so the shape is kept.
+ */
+typedef struct taskHistogram {
+	u16 duration[TASK_HIST_BUCKETS]; // durations of the runs
+	u16 gap[TASK_HIST_BUCKETS]; // gaps from the end of one run to the start of the next one
+} TaskHistogram;
+extern TaskHistogram taskHistograms[32]; // one per entry of tasks[], a task must only be recorded on one core
+
+/// @brief histogram bucket of a duration in cycles
+u32 taskHistBucket(u32 cycles);
+
+/**
+ * @brief calculates a percentile of a histogram
+ * @param hist histogram buckets (TASK_HIST_BUCKETS entries)
+ * @param perMille percentile in 1/10 %, e.g. 999 for p99.9
+ * @return upper bound of the bucket that contains the percentile in cycles, 0 if the histogram is empty, 0xFFFFFFFF if it lies in the last bucket
+ */
+u32 taskHistPercentile(const u16 *hist, u32 perMille);
+
+#define TASK_HIST_READ_RETRIES 16 // attempts of readTaskHistogram before it gives up
+
+/**
+ * @brief takes a tear-free copy of the histograms of a task, can be called from either core
+ * @details Gives up after TASK_HIST_READ_RETRIES attempts that overlapped with an update, e.g. for a task that runs every few µs.
+ * @return true if the copy is consistent, false if it was cleared instead
+ */
+bool readTaskHistogram(u8 taskId, TaskHistogram &copy);
+
+/// @brief clears all histograms, the owning cores clear them on their next update
+void resetTaskHistograms();
+
+#ifndef TASK_PROBES
+#define TASK_PROBES 1 // set to 0 to compile out all task timing (release builds)
+#endif
+
+/**
+ * @brief adds one run of a task to the stats bank of the calling core
+ * @param taskId index into tasks[]
+ * @param start cycle count at the start of the run
+ * @param end cycle count at the end of the run
+ * @return true if this run is the new maximum duration
+ */
+bool recordTaskRun(u8 taskId, u32 start, u32 end);
+
+/**
+ * @brief times the enclosing scope and adds it to the stats of a task
+ * @details Uses the SysTick based cycle counter of the calling core (cycleCount), which gives sub-µs resolution for short tasks.
+ */
+class TaskProbe {
+public:
+	TaskProbe(u8 taskId) : taskId(taskId), start(cycleCount()) {}
+	~TaskProbe() { recordTaskRun(taskId, start, cycleCount()); }
+
+private:
+	const u8 taskId;
+	const u32 start;
+};
+
+#define TASK_PROBE_CONCAT2(a, b) a##b
+#define TASK_PROBE_CONCAT(a, b) TASK_PROBE_CONCAT2(a, b)
+#if TASK_PROBES
+/// @brief times the rest of the enclosing scope as one run of taskId
+#define TASK_PROBE(taskId) TaskProbe TASK_PROBE_CONCAT(taskProbe, __LINE__)(taskId)
+/// @brief starts a manual measurement, the cycle count is stored in a new variable
+#define TASK_PROBE_START(var) const u32 var = cycleCount()
+/// @brief ends a manual measurement, evaluates to true if the run is the new maximum duration
+#define TASK_PROBE_END(taskId, var) recordTaskRun(taskId, var, cycleCount())
+#else
+#define TASK_PROBE(taskId)
+#define TASK_PROBE_START(var)
+#define TASK_PROBE_END(taskId, var) taskProbeDisabled()
+inline bool taskProbeDisabled() { return false; }
+#endif
+
+/// @brief converts a duration in cycles to ns, saturating at 0xFFFFFFFF
+inline u32 cyclesToNs(u32 cycles) {
+	u64 ns = (u64)cycles * 1000 / (F_CPU / 1000000);
+	return ns > 0xFFFFFFFF ? 0xFFFFFFFF : ns;
+}
+/// @brief converts a duration in cycles to µs
+inline u32 cyclesToUs(u32 cycles) { return cycles / (F_CPU / 1000000); }
+
+/// @brief updates the frequency and average duration of all tasks, needs to be scheduled once per second
 void taskManagerLoop();
+
+#define TASK_NONE 0xFF // scheduler task without an entry in tasks[]
+#define SCHEDULER_SLICE_US 500 // time after which the scheduler returns to the caller, unless a task is starved
+#define SCHEDULER_STARVED_FACTOR 4 // a task is starved once it waited this many times its period (+ slice) and then ignores the slice
+
+/// @brief one entry of a scheduler table
+typedef struct schedulerTask {
+	void (*run)(); // task function
+	bool (*ready)(); // optional, the task only runs if this returns true (e.g. if new data is available)
+	u8 taskId; // index into tasks[] for the stats, TASK_NONE for none
+	u8 priority; // higher = more important, 0 = disabled
+	u32 period; // desired time between two starts in µs, 0 = as often as possible
+	u32 budget; // expected maximum duration in µs, used to fit the task into the remaining slice
+	u32 lastStart; // time of the last start in µs (loop time base)
+	u32 lastEnd; // time of the last end in µs
+	u32 lastPass; // scheduler pass in which the task ran the last time
+	u32 overrunCount; // how often the task took longer than its budget
+	u32 deferCount; // how often the task was due, but did not fit into the slice
+	u32 maxLatency; // maximum time between being due and starting in µs
+} SchedulerTask;
+
+/**
+ * @brief runs the due tasks of a scheduler table, highest dynamic priority first
+ *
+ * @details Every task runs at most once per call. At every task boundary the task with the highest dynamic priority
+ * (priority times one plus the number of periods it is overdue) is picked, so starved tasks overtake lower ones after a slow task.
+ * Once SCHEDULER_SLICE_US are used up, only starved tasks still run. Durations and gaps are recorded in tasks[taskId].
+ * @param table scheduler table
+ * @param count number of entries in the table
+ */
+void schedulerLoop(SchedulerTask *table, u32 count);
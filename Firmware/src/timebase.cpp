@@ -0,0 +1,63 @@
+#include "global.h"
+#include "hardware/structs/systick.h"
+
+volatile LoopTime loopTime[2];
+
+static u64 hardwareTime() {
+	return time_us_64();
+}
+static TimeSource timeSource = hardwareTime;
+
+void setTimeSource(TimeSource source) {
+	timeSource = source ? source : hardwareTime;
+}
+
+void __not_in_flash_func(updateLoopTime)() {
+	volatile LoopTime &t = loopTime[get_core_num()];
+	u64 now = timeSource();
+	u32 delta = now - t.us64; // loop iterations are far below 71 minutes, so 32 bits are enough and use the hardware divider
+	u32 remainder = t.usRemainder + delta;
+	t.ms64 += remainder / 1000;
+	t.usRemainder = remainder % 1000;
+	t.us64 = now;
+	t.us = now;
+}
+
+// only core 1 extends its SysTick in software, core 0 uses the interrupt driven count of the Arduino core
+static volatile u32 cycleHigh = 0, cycleLastRaw = 0xFFFFFF;
+
+void initCycleCounter() {
+	if (!(systick_hw->csr & 1)) {
+		// core 1 (the Arduino core only sets up SysTick on core 0), no interrupt, the wraps are counted in cycleCount
+		systick_hw->rvr = 0xFFFFFF;
+		systick_hw->cvr = 0;
+		systick_hw->csr = 0b101; // processor clock, enable
+	}
+	if (get_core_num() == 1)
+		cycleLastRaw = systick_hw->cvr;
+}
+
+/// @brief extends a fresh SysTick value of core 1 to 32 bits
+static inline u32 extendCycleCount(u32 raw) {
+	if (raw > cycleLastRaw) // counts down
+		cycleHigh = cycleHigh + (1 << 24);
+	cycleLastRaw = raw;
+	return cycleHigh + (0xFFFFFF - raw);
+}
+
+u32 __not_in_flash_func(cycleCount)() {
+	if (get_core_num() == 0)
+		return rp2040.getCycleCount(); // core 0 tasks may block for longer than a SysTick wrap
+	return extendCycleCount(systick_hw->cvr);
+}
+
+u32 __not_in_flash_func(cycleCountRaw)() {
+	return systick_hw->cvr;
+}
+
+u32 __not_in_flash_func(cycleCountFromRaw)(u32 raw) {
+	if (get_core_num() == 0)
+		return rp2040.getCycleCount() - ((raw - systick_hw->cvr) & 0xFFFFFF);
+	const u32 now = systick_hw->cvr;
+	return extendCycleCount(now) - ((raw - now) & 0xFFFFFF);
+}
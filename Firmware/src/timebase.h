@@ -0,0 +1,111 @@
+#pragma once
+#include "typedefs.h"
+#include <Arduino.h>
+
+/*
+ * Shared time base
+ *
+ * Instead of every task reading the hardware timer on its own, each core samples the clock once at the start of
+ * every loop iteration (updateLoopTime). Periodic tasks then compare against this cached time with
+ * ElapsedLoopMillis / ElapsedLoopMicros, which costs one RAM read instead of a timer access.
+ * The clock itself can be replaced with setTimeSource, e.g. to step time exactly in a host build.
+ * Code that busy-waits or measures its own duration still needs the live timer (elapsedMillis / elapsedMicros).
+ */
+
+typedef u64 (*TimeSource)(); // returns a monotonic time in µs
+
+typedef struct loopTime {
+	u64 us64; // µs since boot, sampled at the start of the current loop iteration
+	u32 us; // lower 32 bits of us64
+	u64 ms64; // ms since boot, derived from us64
+	u32 usRemainder; // µs that did not make up a full ms yet
+} LoopTime;
+extern volatile LoopTime loopTime[2]; // one entry per core, only written by that core
+
+/**
+ * @brief Replace the clock that feeds the time base
+ * @details Defaults to the 64-bit hardware timer (time_us_64). The source must be monotonic.
+ * @param source new clock, nullptr restores the hardware timer
+ */
+void setTimeSource(TimeSource source);
+
+/// @brief Sample the clock for the calling core, call once at the start of every loop iteration
+void updateLoopTime();
+
+/// @brief µs since boot at the start of the current loop iteration of the calling core
+inline u64 loopMicros64() { return loopTime[get_core_num()].us64; }
+/// @brief lower 32 bits of µs since boot at the start of the current loop iteration of the calling core
+inline u32 loopMicros() { return loopTime[get_core_num()].us; }
+/// @brief ms since boot at the start of the current loop iteration of the calling core
+inline u64 loopMillis64() { return loopTime[get_core_num()].ms64; }
+/// @brief lower 32 bits of ms since boot at the start of the current loop iteration of the calling core
+inline u32 loopMillis() { return loopTime[get_core_num()].ms64; }
+
+/**
+ * @brief starts the SysTick counter of the calling core, call once on each core before using cycleCount
+ * @details SysTick is private to each core, the Arduino core only enables it (with an interrupt) on core 0.
+ */
+void initCycleCounter();
+
+/**
+ * @brief cycle counter of the calling core, for sub-µs task timing
+ * @details Core 0 uses rp2040.getCycleCount, which the SysTick interrupt of the Arduino core extends, because its tasks
+ * (blackbox, flash writes, OSD font upload) can block for longer than a wrap. Core 1 extends the 24-bit SysTick counter
+ * in software, so there it has to be called at least every 63 ms (at 264 MHz) to not miss a wrap, and not in
+ * interrupts. The counters of the two cores are not synchronized.
+ */
+u32 cycleCount();
+
+/// @brief raw 24-bit SysTick value of the calling core, unlike cycleCount safe to take in interrupts
+u32 cycleCountRaw();
+
+/// @brief converts a cycleCountRaw value of the calling core from the last 63 ms to the cycleCount time base
+u32 cycleCountFromRaw(u32 raw);
+
+/**
+ * @brief elapsedMicros replacement that runs on the cached loop time
+ * @details Wraps after 2^32 µs like elapsedMicros. Can be reset on one core and read on the other, times that lie in the
+ * future of the reading core read as 0, that is why the start is kept in 64 bits.
+ */
+class ElapsedLoopMicros {
+public:
+	ElapsedLoopMicros() : start(loopMicros64()) {}
+	ElapsedLoopMicros(u32 val) : start(loopMicros64() - val) {}
+	operator u32() const {
+		u64 s = start;
+		while (s != start) s = start; // torn read while the other core writes
+		const i64 elapsed = loopMicros64() - s;
+		return elapsed < 0 ? 0 : (u32)elapsed;
+	}
+	ElapsedLoopMicros &operator=(u32 val) {
+		start = loopMicros64() - val;
+		return *this;
+	}
+
+private:
+	volatile u64 start;
+};
+
+/**
+ * @brief elapsedMillis replacement that runs on the cached loop time
+ * @details Wraps after 2^32 ms like elapsedMillis. Can be reset on one core and read on the other, times that lie in the
+ * future of the reading core read as 0, that is why the start is kept in 64 bits.
+ */
+class ElapsedLoopMillis {
+public:
+	ElapsedLoopMillis() : start(loopMillis64()) {}
+	ElapsedLoopMillis(u32 val) : start(loopMillis64() - val) {}
+	operator u32() const {
+		u64 s = start;
+		while (s != start) s = start; // torn read while the other core writes
+		const i64 elapsed = loopMillis64() - s;
+		return elapsed < 0 ? 0 : (u32)elapsed;
+	}
+	ElapsedLoopMillis &operator=(u32 val) {
+		start = loopMillis64() - val;
+		return *this;
+	}
+
+private:
+	volatile u64 start;
+};
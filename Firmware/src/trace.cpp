@@ -0,0 +1,32 @@
+#include "global.h"
+
+TraceBuffer traceBuffers[2];
+
+void traceStart() {
+	for (int c = 0; c < 2; c++) {
+		traceBuffers[c].count = 0;
+		traceBuffers[c].state = TRACE_ARMED;
+	}
+}
+
+void __not_in_flash_func(traceRecord)(u32 core, u8 id, u32 start, u32 end) {
+	TraceBuffer &t = traceBuffers[core];
+	if (t.state == TRACE_IDLE) return;
+	if (t.state == TRACE_ARMED) {
+		t.syncUs = time_us_32();
+		t.syncCycles = cycleCount();
+		t.count = 0;
+		t.state = TRACE_RECORDING;
+	}
+	const u32 n = t.count;
+	if (n >= TRACE_EVENTS_PER_CORE) {
+		t.state = TRACE_IDLE;
+		return;
+	}
+	u32 duration = end - start;
+	if (duration > 0xFFFFFF) duration = 0xFFFFFF;
+	t.events[n].start = start;
+	t.events[n].durationId = duration | (u32)id << 24;
+	__dmb();
+	t.count = n + 1;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "typedefs.h"
+
+/*
+ * Event trace
+ *
+ * Records every run of a probed task (see TASK_PROBE) with its start cycle and duration, one buffer per core.
+ * A capture is started with traceStart (MSP TRACE_START) and stops once the buffers are full, then it can be read with
+ * MSP GET_TRACE and turned into a Chrome trace (chrome://tracing, ui.perfetto.dev) with python/traceToChrome.py.
+ * Unlike the per-second stats in tasks[], this shows how the tasks of both cores interleave.
+ */
+
+#define TRACE_EVENTS_PER_CORE 1024 // 8 bytes each, about 20 ms of core 1
+
+enum TraceState : u8 {
+	TRACE_IDLE, // not recording
+	TRACE_ARMED, // recording starts with the next event of the core
+	TRACE_RECORDING, // recording until the buffer is full
+};
+
+typedef struct traceEvent {
+	u32 start; // cycle count of the core at the start of the run
+	u32 durationId; // duration in cycles (lower 24 bits, saturating at 0xFFFFFF), task id (upper 8 bits)
+} TraceEvent;
+
+/// @brief trace buffer of one core, only written by that core
+typedef struct traceBuffer {
+	volatile TraceState state;
+	volatile u32 count; // number of valid events, an event is complete before the count includes it
+	u32 syncCycles; // cycle count of the core when the recording started
+	u32 syncUs; // time_us_32 at the same moment, aligns the cycle counters of both cores
+	TraceEvent events[TRACE_EVENTS_PER_CORE];
+} TraceBuffer;
+extern TraceBuffer traceBuffers[2];
+
+/// @brief clears both buffers and starts a new capture
+void traceStart();
+
+/**
+ * @brief adds one run of a task to the trace of a core, does nothing if no capture is running
+ * @param core core the task ran on (= calling core)
+ * @param id task id
+ * @param start cycle count at the start of the run
+ * @param end cycle count at the end of the run
+ */
+void traceRecord(u32 core, u8 id, u32 start, u32 end);
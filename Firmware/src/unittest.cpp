@@ -1,6 +1,13 @@
 #include "unittest.h"
 #include "utils/fixedPointInt.h"
 #include "ringbuffer.h"
+#include "taskManager.h"
+#include "drivers/esc.h"
+#include "dynNotch.h"
+#include "rpmFilter.h"
+#include "utils/filters.h"
+#include "imu.h"
+#include "pid.h"
 
 u32 ExpectBase::failed = false;
 u32 ExpectBase::succeeded = false;
@@ -82,6 +89,16 @@ bool testRingBuffer() {
 	return ExpectBase::printResults(true, "Ringbuffer");
 }
 
+/// @brief the former sign and magnitude fix64 multiplication, truncates towards zero
+static fix64 fix64MulReference(const fix64 a, const fix64 b) {
+	const i32 sign = a.sign() * b.sign();
+	const u64 pos0 = a.raw * a.sign(), pos1 = b.raw * b.sign();
+	const u64 big = (pos0 >> 32) * (pos1 >> 32);
+	const u64 small = (pos0 & 0xFFFFFFFF) * (pos1 & 0xFFFFFFFF);
+	const u64 med = (pos0 >> 32) * (pos1 & 0xFFFFFFFF) + (pos0 & 0xFFFFFFFF) * (pos1 >> 32);
+	return fix64().setRaw((i64)((big << 32) + med + (small >> 32)) * sign);
+}
+
 bool testFixedPoint() {
 	fix32 a1;
 	a1.setRaw(0b101 << 15);
@@ -360,9 +377,413 @@ bool testFixedPoint() {
 	Expect(b1).withIndex(180).toBeGreaterThan(33330);
 	Expect(b1).withIndex(181).toBeLessThan(33336);
 
+	// widening multiplies and the signed fix64 products against the native / former implementation
+	u32 rng = 12345, mismatches = 0;
+	for (int i = 0; i < 2000; i++) {
+		rng = rng * 1664525 + 1013904223;
+		const u32 x = rng;
+		rng = rng * 1664525 + 1013904223;
+		const u32 y = rng >> (i % 32);
+		if (umul32x32(x, y) != (u64)x * y) mismatches++;
+		if (smul32x32(x, y) != (i64)(i32)x * (i32)y) mismatches++;
+		if (smul32x32(y, -x) != (i64)(i32)y * -(i32)x) mismatches++;
+		// products that fit into fix64 need operands that are a bit smaller than that
+		const fix64 p = fix64().setRaw((i64)(i32)x << (i % 16)), q = fix64().setRaw((i64)(i32)y << (16 - i % 16));
+		// floor instead of towards zero: the former result or one below for negative products
+		const i64 diff = fix64MulReference(p, q).raw - (p * q).raw;
+		if (diff < 0 || diff > 1 || (diff && p.sign() == q.sign())) mismatches++;
+		const i64 diff32 = fix64MulReference(p, fix64(fix32().setRaw(y))).raw - (p * fix32().setRaw(y)).raw;
+		if (diff32 < 0 || diff32 > 1 || (diff32 && p.sign() * fix32().setRaw(y).sign() > 0)) mismatches++;
+	}
+	Expect(mismatches).withIndex(182).toEqual(0);
+	Expect(smul32x32(INT32_MIN, INT32_MIN)).withIndex(183).toEqual(1LL << 62);
+	Expect(umul32x32(0xFFFFFFFF, 0xFFFFFFFF)).withIndex(184).toEqual(0xFFFFFFFE00000001ULL);
+	Expect(fix64(-2.5) * fix64(3)).withIndex(185).toEqual(-7.5);
+	Expect(fix64(-0.25) * fix32(-0.5)).withIndex(186).toEqual(0.125);
+
+	// saturating fix32 arithmetics
+	const fix32 big = 30000, small = -30000;
+	Expect(big.addSat(big).raw).withIndex(187).toEqual(INT32_MAX);
+	Expect(small.addSat(small).raw).withIndex(188).toEqual(INT32_MIN);
+	Expect(big.addSat(small)).withIndex(189).toEqual(0);
+	Expect(big.subSat(small).raw).withIndex(190).toEqual(INT32_MAX);
+	Expect(small.subSat(big).raw).withIndex(191).toEqual(INT32_MIN);
+	Expect(small.subSat(small)).withIndex(192).toEqual(0);
+	Expect(big.mulSat(fix32(2)).raw).withIndex(193).toEqual(INT32_MAX);
+	Expect(big.mulSat(fix32(-2)).raw).withIndex(194).toEqual(INT32_MIN);
+	Expect(fix32(-2.5).mulSat(fix32(1.5))).withIndex(195).toEqual(-3.75);
+	Expect(fix32(100.5).mulSat(fix32(-0.1)).raw).withIndex(196).toEqual((fix32(100.5) * fix32(-0.1)).raw);
+	Expect(fix64(40000).getfix32Sat().raw).withIndex(197).toEqual(INT32_MAX);
+	Expect(fix64(-40000).getfix32Sat().raw).withIndex(198).toEqual(INT32_MIN);
+	Expect(fix64(-1234.5).getfix32Sat()).withIndex(199).toEqual(-1234.5);
+
 	return ExpectBase::printResults(true, "FixedPoint");
 }
 
+bool testTaskHistogram() {
+	Expect(taskHistBucket(0)).withIndex(0).toEqual(0);
+	Expect(taskHistBucket(79)).withIndex(1).toEqual(0);
+	Expect(taskHistBucket(80)).withIndex(2).toEqual(1);
+	Expect(taskHistBucket(128)).withIndex(3).toEqual(4);
+	Expect(taskHistBucket(0xFFFFFFFF)).withIndex(4).toEqual(TASK_HIST_BUCKETS - 1);
+	u16 hist[TASK_HIST_BUCKETS] = {0};
+	Expect(taskHistPercentile(hist, 500)).withIndex(5).toEqual(0);
+	hist[taskHistBucket(1000)] = 989; // 1000 cycles: octave 9, upper bound 1024
+	hist[taskHistBucket(100000)] = 10; // octave 16, upper bound 114688
+	hist[taskHistBucket(0x7FFFFFFF)] = 1;
+	Expect(taskHistPercentile(hist, 500)).withIndex(6).toEqual(1024);
+	Expect(taskHistPercentile(hist, 989)).withIndex(7).toEqual(1024);
+	Expect(taskHistPercentile(hist, 990)).withIndex(8).toEqual(114688);
+	Expect(taskHistPercentile(hist, 999)).withIndex(9).toEqual(114688);
+	Expect(taskHistPercentile(hist, 1000)).withIndex(10).toEqual(0xFFFFFFFF);
+	// a reader that never sees a finished update gives up instead of spinning
+	static TaskHistogram histCopy;
+	const u32 seqSaved = taskBanks[1][TASK_LOOP1].seq;
+	taskBanks[1][TASK_LOOP1].seq = seqSaved | 1;
+	Expect(readTaskHistogram(TASK_LOOP1, histCopy)).withIndex(11).toEqual(false);
+	taskBanks[1][TASK_LOOP1].seq = seqSaved;
+	Expect(readTaskHistogram(TASK_LOOP1, histCopy)).withIndex(12).toEqual(true);
+
+	return ExpectBase::printResults(true, "TaskHistogram");
+}
+
+#if UNIT_TESTS_LONG
+static f32 toF32(fix32 v) { return v.getf32(); }
+static f32 toF32(f32 v) { return v; }
+
+/// @brief amplitude of a filter's response to a sine, after the filter settled
+template <typename F, typename T>
+static f32 filterAmplitude(F &filter, f32 freq, f32 amplitude = 10, u32 sampleFreq = 3200) {
+	f32 peak = 0;
+	for (u32 i = 0; i < 4000; i++) {
+		const f32 out = toF32(filter.update((T)(amplitude * sinf(2 * (f32)PI * freq * i / sampleFreq))));
+		if (i >= 3200 && fabsf(out) > peak) peak = fabsf(out);
+	}
+	return peak;
+}
+
+bool testFilters() {
+	Biquad lowpass(BiquadType::LOWPASS, 100, 3200);
+	for (int i = 0; i < 1000; i++)
+		lowpass.update(10);
+	Expect(fabsf(((fix32)lowpass).getf32() - 10)).withIndex(0).toBeLessThan(0.001f);
+	// -3 dB at the cutoff, second order roll-off above
+	f32 amp = filterAmplitude<Biquad, fix32>(lowpass, 100);
+	Expect(amp).withIndex(1).toBeGreaterThan(6.9f);
+	Expect(amp).withIndex(2).toBeLessThan(7.2f);
+	Expect(filterAmplitude<Biquad, fix32>(lowpass, 1000)).withIndex(3).toBeLessThan(0.15f);
+
+	Biquad notch(BiquadType::NOTCH, 200, 3200, 5);
+	Expect(filterAmplitude<Biquad, fix32>(notch, 200)).withIndex(4).toBeLessThan(0.01f);
+	Expect(filterAmplitude<Biquad, fix32>(notch, 50)).withIndex(5).toBeGreaterThan(9.9f);
+	notch.updateFreq(400);
+	Expect(filterAmplitude<Biquad, fix32>(notch, 400)).withIndex(6).toBeLessThan(0.01f);
+
+	Biquad bandpass(BiquadType::BANDPASS, 200, 3200, 2);
+	amp = filterAmplitude<Biquad, fix32>(bandpass, 200);
+	Expect(amp).withIndex(7).toBeGreaterThan(9.9f);
+	Expect(amp).withIndex(8).toBeLessThan(10.1f);
+	Expect(filterAmplitude<Biquad, fix32>(bandpass, 20)).withIndex(9).toBeLessThan(0.6f);
+
+	// the float back end gives the same response
+	BiquadF lowpassF(BiquadType::LOWPASS, 100, 3200);
+	amp = filterAmplitude<BiquadF, f32>(lowpassF, 100);
+	Expect(amp).withIndex(10).toBeGreaterThan(6.9f);
+	Expect(amp).withIndex(11).toBeLessThan(7.2f);
+	BiquadF notchF(BiquadType::NOTCH, 200, 3200, 5);
+	Expect(filterAmplitude<BiquadF, f32>(notchF, 200)).withIndex(12).toBeLessThan(0.01f);
+
+	// the alpha approximation of PT1 puts the -3 dB point slightly below the cutoff
+	PT2 pt2(100, 3200);
+	amp = filterAmplitude<PT2, fix32>(pt2, 100);
+	Expect(amp).withIndex(13).toBeGreaterThan(6.2f);
+	Expect(amp).withIndex(14).toBeLessThan(7.4f);
+	PT3 pt3(100, 3200);
+	amp = filterAmplitude<PT3, fix32>(pt3, 100);
+	Expect(amp).withIndex(15).toBeGreaterThan(6.2f);
+	Expect(amp).withIndex(16).toBeLessThan(7.4f);
+	// steeper than a PT1 with the same cutoff
+	PT1 pt1(100, 3200);
+	const f32 pt1Amp = filterAmplitude<PT1, fix32>(pt1, 800);
+	const f32 pt2Amp = filterAmplitude<PT2, fix32>(pt2, 800);
+	Expect(pt2Amp).withIndex(17).toBeLessThan(pt1Amp);
+	Expect(filterAmplitude<PT3, fix32>(pt3, 800)).withIndex(18).toBeLessThan(pt2Amp);
+
+	// cutoff tables: same response as the direct calculation, also between two entries, and unity gain at DC
+	Biquad lowpassLut(BiquadType::LOWPASS, 100, 3200);
+	lowpassLut.updateLowpassLut(250);
+	for (int i = 0; i < 1000; i++)
+		lowpassLut.update(10);
+	Expect(fabsf(((fix32)lowpassLut).getf32() - 10)).withIndex(19).toBeLessThan(0.001f);
+	amp = filterAmplitude<Biquad, fix32>(lowpassLut, 250);
+	Expect(amp).withIndex(20).toBeGreaterThan(6.95f);
+	Expect(amp).withIndex(21).toBeLessThan(7.2f);
+	PT1 pt1Lut(100, 3200), pt1Direct(250, 3200);
+	pt1Lut.updateCutoffFreqLut(250);
+	Expect(fabsf(filterAmplitude<PT1, fix32>(pt1Lut, 250) - filterAmplitude<PT1, fix32>(pt1Direct, 250))).withIndex(22).toBeLessThan(0.02f);
+
+	// the multi-axis versions give the same results as one filter per axis
+	PT1N<3> pt1N(100, 3200);
+	PT1 pt1Single[3] = {PT1(100, 3200), PT1(100, 3200), PT1(100, 3200)};
+	BiquadN<3> biquadN(BiquadType::NOTCH, 200, 3200, 5);
+	Biquad biquadSingle[3] = {Biquad(BiquadType::NOTCH, 200, 3200, 5), Biquad(BiquadType::NOTCH, 200, 3200, 5), Biquad(BiquadType::NOTCH, 200, 3200, 5)};
+	u32 mismatches = 0;
+	for (int i = 0; i < 500; i++) {
+		fix32 data[3] = {fix32(i % 7) * 13, fix32(i % 11) * -5, fix32(i % 5) * 2.5f};
+		pt1N.update(data);
+		for (int ax = 0; ax < 3; ax++)
+			if (pt1N[ax] != pt1Single[ax].update(data[ax])) mismatches++;
+		fix32 expected[3];
+		for (int ax = 0; ax < 3; ax++)
+			expected[ax] = biquadSingle[ax].update(data[ax]);
+		biquadN.update(data);
+		for (int ax = 0; ax < 3; ax++)
+			if (data[ax] != expected[ax] || biquadN[ax] != expected[ax]) mismatches++;
+	}
+	Expect(mismatches).withIndex(23).toEqual(0);
+
+	return ExpectBase::printResults(true, "Filters");
+}
+
+bool testRpmFilter() {
+	initFixTrig();
+	for (int m = 0; m < 4; m++)
+		escRpm[m] = 20000; // 333.3 Hz
+	escErpmFail = 0;
+	initRpmFilter();
+	f32 peak[3] = {0, 0, 0};
+	const f32 freqs[3] = {20000 / 60.f, 3 * 20000 / 60.f, 50}; // fundamental, 3rd harmonic, below the bank
+	for (int i = 0; i < 3200; i++) {
+		rpmFilterUpdate();
+		fix32 data[3];
+		for (int ax = 0; ax < 3; ax++)
+			data[ax] = 100 * sinf(2 * (f32)PI * freqs[ax] * i / 3200);
+		rpmFilterApply(data);
+		if (i < 1600) continue;
+		for (int ax = 0; ax < 3; ax++)
+			if (fabsf(data[ax].getf32()) > peak[ax]) peak[ax] = fabsf(data[ax].getf32());
+	}
+	Expect(rpmNotches.active).withIndex(0).toEqual(0xFFF);
+	Expect(rpmFilterMotorFreq[0].getf32()).withIndex(1).toBeGreaterThan(333.2f);
+	Expect(rpmFilterMotorFreq[0].getf32()).withIndex(2).toBeLessThan(333.5f);
+	Expect(peak[0]).withIndex(3).toBeLessThan(3);
+	Expect(peak[1]).withIndex(4).toBeLessThan(3);
+	Expect(peak[2]).withIndex(5).toBeGreaterThan(90);
+	escErpmFail = 0xF;
+	rpmFilterUpdate();
+	Expect(rpmFilterMotorFreq[0].getf32()).withIndex(6).toEqual(0);
+
+	for (int m = 0; m < 4; m++)
+		escRpm[m] = 0;
+	escErpmFail = 0;
+	initRpmFilter();
+	return ExpectBase::printResults(true, "RpmFilter");
+}
+
+bool testDynNotch() {
+	initFixTrig();
+	initDynNotch();
+	// roll: resonance at 260 Hz, pitch: 180 Hz and 470 Hz, yaw: only broadband noise
+	u32 rng = 1;
+	f32 peak = 0;
+	for (int i = 0; i < 3200; i++) {
+		rng = rng * 1664525 + 1013904223;
+		const f32 t = i / 3200.f, noise = (i32)(rng >> 16 & 0xFF) / 64.f - 2;
+		fix32 data[3] = {
+			50 * sinf(2 * (f32)PI * 260 * t) + noise,
+			30 * sinf(2 * (f32)PI * 180 * t) + 20 * sinf(2 * (f32)PI * 470 * t) + noise,
+			noise,
+		};
+		dynNotchUpdate();
+		dynNotchPush(data);
+		dynNotchApply(data);
+		while (dynNotchSamplesAvailable())
+			dynNotchLoop();
+		if (i >= 2400 && fabsf(data[0].getf32()) > peak) peak = fabsf(data[0].getf32());
+	}
+	Expect(fix32().setRaw(dynNotchFreq[0][0]).getf32()).withIndex(0).toBeGreaterThan(255);
+	Expect(fix32().setRaw(dynNotchFreq[0][0]).getf32()).withIndex(1).toBeLessThan(265);
+	Expect(fix32().setRaw(dynNotchFreq[1][0]).getf32()).withIndex(2).toBeGreaterThan(175);
+	Expect(fix32().setRaw(dynNotchFreq[1][0]).getf32()).withIndex(3).toBeLessThan(185);
+	Expect(fix32().setRaw(dynNotchFreq[1][1]).getf32()).withIndex(4).toBeGreaterThan(465);
+	Expect(fix32().setRaw(dynNotchFreq[1][1]).getf32()).withIndex(5).toBeLessThan(475);
+	Expect(dynNotchFreq[2][0]).withIndex(6).toEqual(0);
+	// the notch removes most of the resonance, the noise remains
+	Expect(peak).withIndex(7).toBeLessThan(10);
+
+	initDynNotch();
+	return ExpectBase::printResults(true, "DynNotch");
+}
+
+/// @brief one accel fusion step of the float estimator that the fixed point one replaced
+static void accelFusionStepFloat(Quaternion *q, const i16 *raw) {
+	const f32 o[3] = {
+		q->w * q->v[1] * -2 + q->v[0] * q->v[2] * -2,
+		q->v[1] * q->v[2] * -2 + q->w * q->v[0] * 2,
+		-q->v[2] * q->v[2] + q->v[1] * q->v[1] + q->v[0] * q->v[0] - q->w * q->w,
+	};
+	const f32 norm = sqrtf((f32)raw[0] * raw[0] + (f32)raw[1] * raw[1] + (f32)raw[2] * raw[2]);
+	const f32 a[3] = {raw[1] / norm, raw[0] / norm, -raw[2] / norm};
+	Quaternion shortestPath;
+	Quaternion_from_unit_vecs(o, a, &shortestPath);
+	f32 axis[3];
+	f32 angle = Quaternion_toAxisAngle(&shortestPath, axis);
+	if (angle > .0002f * ACCEL_FUSION_DIVIDER) angle = .0002f * ACCEL_FUSION_DIVIDER;
+	const f32 c[3] = {axis[0] * angle * .5f, axis[1] * angle * .5f, axis[2] * angle * .5f};
+	Quaternion b;
+	b.w = q->w - c[0] * q->v[0] - c[1] * q->v[1] - c[2] * q->v[2];
+	b.v[0] = c[0] * q->w + q->v[0] + c[1] * q->v[2] - c[2] * q->v[1];
+	b.v[1] = q->v[1] - c[0] * q->v[2] + c[1] * q->w + c[2] * q->v[0];
+	b.v[2] = q->v[2] + c[0] * q->v[1] - c[1] * q->v[0] + c[2] * q->w;
+	Quaternion_normalize(&b, q);
+}
+
+bool testAttitude() {
+	initFixTrig();
+	startFixTrig();
+	// asinFix against asinf over the whole range, including the steep part near +-1
+	f32 maxErr = 0;
+	for (int i = -1000; i <= 1000; i++) {
+		const fix32 x = i / 1000.f;
+		const f32 err = fabsf(asinFix(x).getf32() - asinf(x.getf32()));
+		if (err > maxErr) maxErr = err;
+	}
+	Expect(maxErr).withIndex(0).toBeLessThan(0.00005f);
+	Expect(asinFix(1.5f)).withIndex(1).toEqual(FIX_PI_2);
+
+	// inverse square root of 2.30 numbers and integers
+	maxErr = 0;
+	const u32 inputs[] = {1, 3, 687, 2048 * 2048, QUAT_FIX_ONE / 3, QUAT_FIX_ONE, 3UL * QUAT_FIX_ONE, 0xFFFFFFFF};
+	for (u32 x : inputs) {
+		i32 halfShift;
+		const f64 y = (f64)quatFixInvSqrt(x, &halfShift) / QUAT_FIX_ONE * (1 << halfShift) / 32768;
+		const f64 err = fabs(y * sqrt((f64)x) - 1);
+		if (err > maxErr) maxErr = err;
+	}
+	Expect(maxErr).withIndex(2).toBeLessThan(0.000001f);
+
+	// Newton normalization keeps the direction of the float normalization
+	Quaternion qf;
+	Quaternion_set(0.5f * 1.002f, 0.1f * 1.002f, -0.7f * 1.002f, sqrtf(0.25f) * 1.002f, &qf);
+	QuaternionFix qFix;
+	QuaternionFix_fromFloat(&qf, &qFix);
+	QuaternionFix_normalize(&qFix);
+	Quaternion_normalize(&qf, &qf);
+	Quaternion qBack;
+	QuaternionFix_toFloat(&qFix, &qBack);
+	maxErr = fmaxf(fmaxf(fabsf(qBack.w - qf.w), fabsf(qBack.v[0] - qf.v[0])), fmaxf(fabsf(qBack.v[1] - qf.v[1]), fabsf(qBack.v[2] - qf.v[2])));
+	Expect(maxErr).withIndex(3).toBeLessThan(0.000005f);
+
+	// one second of gyro integration against the float version of the same formula
+	const QuaternionFix qSaved = q;
+	const fix32 dtSaved = gyroSampleDtUs;
+	i16 *const gyroSaved = gyroDataRaw; // not set before gyroInit
+	i16 gyroTest[3];
+	gyroDataRaw = gyroTest;
+	QuaternionFix_setIdentity(&q);
+	Quaternion_setIdentity(&qf);
+	gyroSampleDtUs = 312.5f;
+	const f32 rawToHalfAngle = PI * 4000 / 65536 / 180 / 1000000 / 2 * 312.5f;
+	for (int i = 0; i < 3200; i++) {
+		gyroDataRaw[0] = 3000 * sinf(i * 0.002f);
+		gyroDataRaw[1] = -2000 + i;
+		gyroDataRaw[2] = 7 * (i % 300);
+		updateFromGyro();
+		const f32 all[] = {-gyroDataRaw[1] * rawToHalfAngle, -gyroDataRaw[0] * rawToHalfAngle, gyroDataRaw[2] * rawToHalfAngle};
+		const Quaternion b = qf;
+		qf.w += -b.v[0] * all[0] - b.v[1] * all[1] - b.v[2] * all[2];
+		qf.v[0] += b.w * all[0] - b.v[1] * all[2] + b.v[2] * all[1];
+		qf.v[1] += b.w * all[1] + b.v[0] * all[2] - b.v[2] * all[0];
+		qf.v[2] += b.w * all[2] - b.v[0] * all[1] + b.v[1] * all[0];
+		Quaternion_normalize(&qf, &qf);
+	}
+	QuaternionFix_toFloat(&q, &qBack);
+	maxErr = fmaxf(fmaxf(fabsf(qBack.w - qf.w), fabsf(qBack.v[0] - qf.v[0])), fmaxf(fabsf(qBack.v[1] - qf.v[1]), fabsf(qBack.v[2] - qf.v[2])));
+	Expect(maxErr).withIndex(4).toBeLessThan(0.0001f);
+	Expect(fabsf(qf.w)).withIndex(5).toBeLessThan(0.99f); // it did rotate
+	const f32 pitchErr = asinFix(fix32().setRaw(((i64)q.w * q.v[1] + (i64)q.v[2] * q.v[0]) >> 43)).getf32() - asinf(2 * (qf.w * qf.v[1] + qf.v[2] * qf.v[0]));
+	Expect(fabsf(pitchErr)).withIndex(6).toBeLessThan(0.0002f);
+
+	// acosFix, sqrtFix and invSqrtFix
+	startFixTrig();
+	maxErr = 0;
+	for (int i = -1000; i <= 1000; i++) {
+		const fix32 x = i / 1000.f;
+		const f32 err = fabsf(acosFix(x).getf32() - acosf(x.getf32()));
+		if (err > maxErr) maxErr = err;
+	}
+	Expect(maxErr).withIndex(7).toBeLessThan(0.00005f);
+	// square roots: relative error over the whole fix32 range, plus the fix32 resolution
+	f32 maxRel = 0, maxRelInv = 0;
+	for (u32 raw = 1; raw < 0x7FFFFFFF - 0x7FFFFFFF / 3000; raw += raw / 64 + 7) {
+		const f64 x = raw / 65536.;
+		const f64 root = sqrt(x);
+		// relative error beyond the rounding to fix32
+		const f64 rel = (fabs(sqrtFix(fix32().setRaw(raw)).getf64() - root) - 0.5 / 65536) / root;
+		const f64 relInv = (fabs(invSqrtFix(fix32().setRaw(raw)).getf64() - 1 / root) - 0.5 / 65536) * root;
+		if (rel > maxRel) maxRel = rel;
+		if (relInv > maxRelInv) maxRelInv = relInv;
+	}
+	Expect(maxRel).withIndex(8).toBeLessThan(0.0000005f);
+	Expect(maxRelInv).withIndex(9).toBeLessThan(0.000002f);
+	Expect(sqrtFix(fix32(-1))).withIndex(10).toEqual(0);
+	Expect(sqrtFix(fix32(4))).withIndex(11).toEqual(2);
+	Expect(invSqrtFix(fix32(0.25f))).withIndex(12).toEqual(2);
+
+	// one accel fusion step against the float version: limited correction (also near full scale), upside down, none
+	const PT1N<3> accelFilterSaved = accelDataFiltered;
+	i16 *const accelSaved = accelDataRaw;
+	i16 accelTest[3];
+	accelDataRaw = accelTest;
+	const struct {
+		f32 w, x, y, z;
+		i16 accel[3];
+	} fusionCases[] = {
+		{1, 0, 0, 0, {300, -500, 2000}},
+		{0.9f, 0.3f, -0.2f, 0.25f, {30000, -28000, 31000}},
+		{1, 0, 0, 0, {0, 0, -2048}}, // measured down is expected up: no cross product, fixed axis
+		{0, 1, 0, 0, {0, 0, 2048}}, // same, but the estimate is upside down
+		{1, 0, 0, 0, {0, 0, 2048}}, // nothing to correct
+	};
+	maxErr = 0;
+	for (const auto &fc : fusionCases) {
+		imuInit(); // restarts the step at phase 0
+		Quaternion_set(fc.w, fc.x, fc.y, fc.z, &qf);
+		Quaternion_normalize(&qf, &qf);
+		QuaternionFix_fromFloat(&qf, &q);
+		for (int i = 0; i < 3; i++)
+			accelTest[i] = fc.accel[i];
+		for (int i = 0; i < ACCEL_FUSION_PHASES; i++)
+			updateFromAccel();
+		accelFusionStepFloat(&qf, accelTest);
+		QuaternionFix_toFloat(&q, &qBack);
+		const f32 err = fmaxf(fmaxf(fabsf(qBack.w - qf.w), fabsf(qBack.v[0] - qf.v[0])), fmaxf(fabsf(qBack.v[1] - qf.v[1]), fabsf(qBack.v[2] - qf.v[2])));
+		if (err > maxErr) maxErr = err;
+	}
+	Expect(maxErr).withIndex(13).toBeLessThan(0.000005f);
+	// below the limit the whole angle is corrected, acosf in the float version cannot resolve angles this small
+	imuInit();
+	accelTest[0] = 6;
+	accelTest[1] = 0;
+	accelTest[2] = 16000; // 0.000375 rad
+	for (int i = 0; i < ACCEL_FUSION_PHASES; i++)
+		updateFromAccel();
+	QuaternionFix_toFloat(&q, &qBack);
+	const f32 downX = qBack.w * qBack.v[1] * -2 + qBack.v[0] * qBack.v[2] * -2;
+	const f32 downY = qBack.v[1] * qBack.v[2] * -2 + qBack.w * qBack.v[0] * 2;
+	Expect(fabsf(downY - 6 / sqrtf(6 * 6 + 16000 * 16000))).withIndex(14).toBeLessThan(0.000002f);
+	Expect(fabsf(downX)).withIndex(15).toBeLessThan(0.000002f);
+
+	imuInit();
+	accelDataFiltered = accelFilterSaved;
+	accelDataRaw = accelSaved;
+	q = qSaved;
+	gyroSampleDtUs = dtSaved;
+	gyroDataRaw = gyroSaved;
+	return ExpectBase::printResults(true, "Attitude");
+}
+#endif
+
 void runUnitTests() {
 	bool testsFailed = false;
 	CHECK_TYPE_SIZE(f32, 4);
@@ -380,6 +801,13 @@ void runUnitTests() {
 	do {
 		testsFailed = testRingBuffer() || testsFailed;
 		testsFailed = testFixedPoint() || testsFailed;
+		testsFailed = testTaskHistogram() || testsFailed;
+#if UNIT_TESTS_LONG
+		testsFailed = testFilters() || testsFailed;
+		testsFailed = testRpmFilter() || testsFailed;
+		testsFailed = testDynNotch() || testsFailed;
+		testsFailed = testAttitude() || testsFailed;
+#endif
 		if (testsFailed) {
 			Serial.println("Unit tests failed, rerun to see results.");
 			ExpectBase::enableSilent(false);
@@ -387,6 +815,9 @@ void runUnitTests() {
 				firstRun = false;
 				sleep_ms(10000);
 			} else {
+#ifdef SITL
+				exit(1); // no one to rerun the tests on the host
+#endif
 				sleep_ms(120000);
 			}
 		}
@@ -1,6 +1,18 @@
 #pragma once
 #include <typedefs.h>
 
+#ifndef UNIT_TESTS_LONG
+#ifdef SITL
+#define UNIT_TESTS_LONG 1 // filter, notch and attitude accuracy tests, hundreds of ms of software float on the target
+#else
+#define UNIT_TESTS_LONG 0 // the target only runs the quick tests at boot, build with -DUNIT_TESTS_LONG=1 for all of them
+#endif
+#endif
+
+/**
+ * @brief runs the unit tests, and on failure blocks with the results on Serial
+ * @details The long accuracy tests only run if UNIT_TESTS_LONG is set (default in the host build).
+ */
 void runUnitTests();
 
 template <typename T>
@@ -1,15 +1,112 @@
-#include "filters.h"
+#include "global.h"
 
-PT1::PT1(fix32 cutoffFreq, u32 sampleFreq) : sampleFreq(sampleFreq) {
+fix32 pt1Alpha(fix32 cutoffFreq, u32 sampleFreq) {
 	fix32 omega = FIX_2PI * cutoffFreq / sampleFreq;
-	alpha = omega / (omega + 1);
+	return omega / (omega + 1);
+}
+
+PT1::PT1(fix32 cutoffFreq, u32 sampleFreq) : sampleFreq(sampleFreq) {
+	alpha = pt1Alpha(cutoffFreq, sampleFreq);
 }
 
 PT1::PT1(fix32 alpha) : alpha(alpha) {}
 
+// ======================== compile-time generated cutoff tables ========================
+
+/// @brief FILTER_LUT_SIZE entries of a cutoff table, a struct so that constexpr functions can return it
+typedef struct filterLut {
+	i32 v[FILTER_LUT_SIZE];
+	inline constexpr i32 operator[](const u32 i) const {
+		return v[i];
+	};
+} FilterLut;
+
+/// @brief omega / (omega + 1) as in pt1Alpha
+static constexpr f64 constPt1Alpha(f64 freq) {
+	const f64 omega = 2 * PI * freq / FILTER_LUT_SAMPLE_FREQ;
+	return omega / (omega + 1);
+}
+
+/// @brief a1 and a2 of a Butterworth low pass as in biquadCoeffs
+static constexpr f64 constLowpassA(f64 freq, bool a2) {
+	const f64 omega = 2 * PI * freq / FILTER_LUT_SAMPLE_FREQ;
+	const f64 alpha = constSin(omega) / (2 * (f64)BIQUAD_Q_BUTTERWORTH);
+	return a2 ? (1 - alpha) / (1 + alpha) : -2 * constCos(omega) / (1 + alpha);
+}
+static constexpr f64 constLowpassA1(f64 freq) { return constLowpassA(freq, false); }
+static constexpr f64 constLowpassA2(f64 freq) { return constLowpassA(freq, true); }
+
+/// @brief rounded entries of f at 0, FILTER_LUT_STEP, 2 * FILTER_LUT_STEP... Hz
+static constexpr FilterLut makeFilterLut(f64 (*f)(f64), f64 scale, f64 firstFreq = 0) {
+	FilterLut lut = {};
+	for (int i = 0; i < FILTER_LUT_SIZE; i++) {
+		const f64 v = f(i ? i * FILTER_LUT_STEP : firstFreq) * scale;
+		lut.v[i] = (i32)(v < 0 ? v - 0.5 : v + 0.5);
+	}
+	return lut;
+}
+
+/// @brief checks that all entries lie within min...max, and rise if requested
+static constexpr bool filterLutValid(const FilterLut &lut, i32 min, i32 max, bool rising) {
+	for (int i = 0; i < FILTER_LUT_SIZE; i++) {
+		if (lut[i] < min || lut[i] > max) return false;
+		if (rising && i && lut[i] <= lut[i - 1]) return false;
+	}
+	return true;
+}
+
+// in RAM: read in the PID loop. A cutoff of 0 would put the biquad poles on the unit circle, the first entry uses 1 Hz instead
+static constexpr FilterLut pt1AlphaTable __not_in_flash("filterLut") = makeFilterLut(constPt1Alpha, 65536); // fix32 raw
+static constexpr FilterLut lowpassA1Table __not_in_flash("filterLut") = makeFilterLut(constLowpassA1, 1 << BIQUAD_SHIFT, 1); // 2.30
+static constexpr FilterLut lowpassA2Table __not_in_flash("filterLut") = makeFilterLut(constLowpassA2, 1 << BIQUAD_SHIFT, 1); // 2.30
+static_assert(pt1AlphaTable[0] == 0 && filterLutValid(pt1AlphaTable, 0, 65535, true), "PT1 alpha rises within 0...1");
+static_assert(filterLutValid(lowpassA1Table, INT32_MIN, INT32_MAX, true) && lowpassA1Table[50] == 0, "a1 rises within -2...2, 0 at a quarter of the sample frequency");
+static_assert(filterLutValid(lowpassA2Table, 0, 1 << BIQUAD_SHIFT, false) && lowpassA2Table[49] > lowpassA2Table[50], "a2 within 0...1, lowest at a quarter of the sample frequency");
+
+/**
+ * @brief position in the cutoff tables
+ * @param freq cutoff frequency, clamped to the table range
+ * @param index first table entry
+ * @param frac position between index and index + 1, 16 bits
+ */
+static inline void lutPosition(fix32 freq, u32 &index, u32 &frac) {
+	static_assert(FILTER_LUT_STEP == 16, "lutPosition divides by shifting");
+	i32 pos = freq.raw >> 4; // 16.16 position in the table
+	if (pos < 0) pos = 0;
+	if (pos >= (FILTER_LUT_SIZE - 1) << 16) pos = ((FILTER_LUT_SIZE - 1) << 16) - 1;
+	index = pos >> 16;
+	frac = pos & 0xFFFF;
+}
+
+static inline i32 lutInterpolate(const FilterLut &lut, u32 index, u32 frac) {
+	return lut[index] + (i32)(((i64)(lut[index + 1] - lut[index]) * frac) >> 16);
+}
+
+fix32 __not_in_flash_func(pt1AlphaLut)(fix32 cutoffFreq) {
+	u32 index, frac;
+	lutPosition(cutoffFreq, index, frac);
+	return fix32().setRaw(lutInterpolate(pt1AlphaTable, index, frac));
+}
+
+BiquadCoeffsFix __not_in_flash_func(lowpassCoeffsLut)(fix32 freq) {
+	u32 index, frac;
+	lutPosition(freq, index, frac);
+	BiquadCoeffsFix c;
+	c.a1 = lutInterpolate(lowpassA1Table, index, frac);
+	c.a2 = lutInterpolate(lowpassA2Table, index, frac);
+	// unity gain at DC: (b0 + b1 + b2) / (1 + a1 + a2) = 1 with b1 = 2 b0 = 2 b2
+	c.b0 = ((1 << BIQUAD_SHIFT) + c.a1 + c.a2) >> 2;
+	c.b1 = 2 * c.b0;
+	c.b2 = c.b0;
+	return c;
+}
+
+void PT1::updateCutoffFreqLut(fix32 cutoffFreq) {
+	alpha = pt1AlphaLut(cutoffFreq);
+}
+
 void PT1::updateCutoffFreq(fix32 cutoffFreq) {
-	fix32 omega = FIX_2PI * cutoffFreq / sampleFreq;
-	alpha = omega / (omega + 1);
+	alpha = pt1Alpha(cutoffFreq, sampleFreq);
 }
 void PT1::updateAlpha(fix32 alpha) { this->alpha = alpha; }
 
@@ -26,4 +123,96 @@ fix32 PT1::rollover() {
 		y -= boundDiff;
 	}
 	return y;
-}
\ No newline at end of file
+}
+
+// cutoff of each stage, so that n stages in series are at -3 dB at the cutoff: 1 / sqrt(2^(1/n) - 1)
+#define PT2_CUTOFF_CORRECTION 1.553773974f
+#define PT3_CUTOFF_CORRECTION 1.961459177f
+
+PT2::PT2(fix32 cutoffFreq, u32 sampleFreq) : sampleFreq(sampleFreq) {
+	updateCutoffFreq(cutoffFreq);
+}
+
+void PT2::updateCutoffFreq(fix32 cutoffFreq) {
+	alpha = pt1Alpha(cutoffFreq * PT2_CUTOFF_CORRECTION, sampleFreq);
+}
+
+PT3::PT3(fix32 cutoffFreq, u32 sampleFreq) : sampleFreq(sampleFreq) {
+	updateCutoffFreq(cutoffFreq);
+}
+
+void PT3::updateCutoffFreq(fix32 cutoffFreq) {
+	alpha = pt1Alpha(cutoffFreq * PT3_CUTOFF_CORRECTION, sampleFreq);
+}
+
+BiquadCoeffs biquadCoeffs(BiquadType type, f32 freq, f32 q, u32 sampleFreq) {
+	const f32 omega = 2 * PI * freq / sampleFreq;
+	const f32 cs = cosf(omega);
+	const f32 alpha = sinf(omega) / (2 * q);
+	const f32 a0 = 1 + alpha;
+	BiquadCoeffs c;
+	switch (type) {
+	case BiquadType::LOWPASS:
+		c.b0 = (1 - cs) / 2 / a0;
+		c.b1 = (1 - cs) / a0;
+		c.b2 = c.b0;
+		break;
+	case BiquadType::NOTCH:
+		c.b0 = 1 / a0;
+		c.b1 = -2 * cs / a0;
+		c.b2 = c.b0;
+		break;
+	case BiquadType::BANDPASS:
+		c.b0 = alpha / a0;
+		c.b1 = 0;
+		c.b2 = -c.b0;
+		break;
+	}
+	c.a1 = -2 * cs / a0;
+	c.a2 = (1 - alpha) / a0;
+	return c;
+}
+
+Biquad::Biquad(BiquadType type, fix32 freq, u32 sampleFreq, fix32 q) : type(type), sampleFreq(sampleFreq) {
+	updateParams(freq, q);
+}
+
+BiquadCoeffsFix biquadCoeffsFix(BiquadType type, fix32 freq, fix32 q, u32 sampleFreq) {
+	const BiquadCoeffs c = biquadCoeffs(type, freq.getf32(), q.getf32(), sampleFreq);
+	const f32 scale = 1 << BIQUAD_SHIFT;
+	BiquadCoeffsFix f;
+	f.b0 = c.b0 * scale;
+	f.b1 = c.b1 * scale;
+	f.b2 = c.b2 * scale;
+	f.a1 = c.a1 * scale;
+	f.a2 = c.a2 * scale;
+	return f;
+}
+
+void Biquad::updateParams(fix32 freq, fix32 q) {
+	this->q = q;
+	c = biquadCoeffsFix(type, freq, q, sampleFreq);
+}
+
+void notchCoeffsFix(fix32 freq, fix32 q, u32 sampleFreq, i32 &b0, i32 &a1, i32 &a2) {
+	const fix32 omega = FIX_2PI * freq / sampleFreq;
+	const fix32 cs = cosFix(omega);
+	const fix32 alpha = sinFix(omega) / (q * 2);
+	const fix32 invA0 = fix32(1) / (alpha + 1);
+	// fix32 has 16 fractional bits
+	b0 = invA0.raw << (BIQUAD_SHIFT - 16);
+	a1 = -(cs * invA0 * 2).raw << (BIQUAD_SHIFT - 16);
+	a2 = ((fix32(1) - alpha) * invA0).raw << (BIQUAD_SHIFT - 16);
+}
+
+void Biquad::updateLowpassLut(fix32 freq) {
+	c = lowpassCoeffsLut(freq);
+}
+
+BiquadF::BiquadF(BiquadType type, f32 freq, u32 sampleFreq, f32 q) : type(type), sampleFreq(sampleFreq) {
+	updateParams(freq, q);
+}
+
+void BiquadF::updateParams(f32 freq, f32 q) {
+	c = biquadCoeffs(type, freq, q, sampleFreq);
+}
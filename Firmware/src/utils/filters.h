@@ -2,6 +2,25 @@
 #include "fixedPointInt.h"
 #include "typedefs.h"
 
+#define FILTER_LUT_SAMPLE_FREQ 3200 // sample frequency of the cutoff tables
+#define FILTER_LUT_STEP 16 // Hz between two entries of the cutoff tables
+#define FILTER_LUT_SIZE 64 // entries of the cutoff tables, cutoffs from 0 to 1008 Hz
+
+/**
+ * @brief alpha of a PT1 for a cutoff frequency, with divisions
+ *
+ * @param cutoffFreq Cutoff frequency
+ * @param sampleFreq Sample frequency of the filter
+ */
+fix32 pt1Alpha(fix32 cutoffFreq, u32 sampleFreq);
+
+/**
+ * @brief alpha of a PT1 for a cutoff frequency from the compile-time cutoff tables, interpolated, no division
+ *
+ * @param cutoffFreq Cutoff frequency, up to (FILTER_LUT_SIZE - 1) * FILTER_LUT_STEP, at FILTER_LUT_SAMPLE_FREQ
+ */
+fix32 pt1AlphaLut(fix32 cutoffFreq);
+
 /**
  * @brief A first order low pass filter
  *
@@ -51,6 +70,13 @@ public:
 	 * @param cutoffFreq The new cutoff frequency
 	 */
 	void updateCutoffFreq(fix32 cutoffFreq);
+	/**
+	 * @brief Set a new cutoff frequency from the compile-time cutoff tables, fast enough to be called every loop
+	 *
+	 * @details Interpolates between the table entries, no division. Only for a sample frequency of FILTER_LUT_SAMPLE_FREQ.
+	 * @param cutoffFreq The new cutoff frequency, up to (FILTER_LUT_SIZE - 1) * FILTER_LUT_STEP
+	 */
+	void updateCutoffFreqLut(fix32 cutoffFreq);
 	/**
 	 * @brief Set a new alpha value for the filter, useful for dynamic filters
 	 *
@@ -67,4 +93,388 @@ private:
 	fix32 lowerBound = 0;
 	fix32 upperBound = 0;
 	fix32 boundDiff = 0;
-};
\ No newline at end of file
+};
+
+/**
+ * @brief A second order low pass filter, two PT1 in series
+ *
+ * @details The cutoff of the stages is raised, so that the whole filter is at -3 dB at the cutoff frequency. Less phase delay
+ * than a PT1 with the same attenuation at high frequencies.
+ */
+class PT2 {
+public:
+	/**
+	 * @brief Construct a new PT2 object
+	 *
+	 * @param cutoffFreq -3 dB frequency of the filter
+	 * @param sampleFreq Sample frequency of the filter (rate at which .update() is called)
+	 */
+	PT2(fix32 cutoffFreq, u32 sampleFreq);
+	/**
+	 * @brief provide a new value to the filter
+	 *
+	 * @param value The new value/sample to be filtered
+	 * @return fix32 The filtered value
+	 */
+	inline fix32 update(fix32 value) {
+		y1 = y1 + alpha * (value - y1);
+		y = y + alpha * (y1 - y);
+		return y;
+	}
+	/**
+	 * @brief Set a new cutoff frequency for the filter, useful for dynamic filters
+	 *
+	 * @param cutoffFreq The new -3 dB frequency
+	 */
+	void updateCutoffFreq(fix32 cutoffFreq);
+	/// @brief Get the current value of the filter
+	inline operator fix32() const { return y; }
+
+private:
+	fix32 alpha;
+	fix32 y1 = 0, y = 0;
+	u32 sampleFreq;
+};
+
+/**
+ * @brief A third order low pass filter, three PT1 in series
+ *
+ * @details The cutoff of the stages is raised, so that the whole filter is at -3 dB at the cutoff frequency.
+ */
+class PT3 {
+public:
+	/**
+	 * @brief Construct a new PT3 object
+	 *
+	 * @param cutoffFreq -3 dB frequency of the filter
+	 * @param sampleFreq Sample frequency of the filter (rate at which .update() is called)
+	 */
+	PT3(fix32 cutoffFreq, u32 sampleFreq);
+	/**
+	 * @brief provide a new value to the filter
+	 *
+	 * @param value The new value/sample to be filtered
+	 * @return fix32 The filtered value
+	 */
+	inline fix32 update(fix32 value) {
+		y1 = y1 + alpha * (value - y1);
+		y2 = y2 + alpha * (y1 - y2);
+		y = y + alpha * (y2 - y);
+		return y;
+	}
+	/**
+	 * @brief Set a new cutoff frequency for the filter, useful for dynamic filters
+	 *
+	 * @param cutoffFreq The new -3 dB frequency
+	 */
+	void updateCutoffFreq(fix32 cutoffFreq);
+	/// @brief Get the current value of the filter
+	inline operator fix32() const { return y; }
+
+private:
+	fix32 alpha;
+	fix32 y1 = 0, y2 = 0, y = 0;
+	u32 sampleFreq;
+};
+
+/// @brief Response of a biquad filter
+enum class BiquadType : u8 {
+	LOWPASS, // 12 dB/octave above the frequency, Q = 0.7071 for a Butterworth response
+	NOTCH, // zero gain at the frequency, Q = frequency / bandwidth
+	BANDPASS, // unity gain at the frequency, Q = frequency / bandwidth
+};
+
+#define BIQUAD_Q_BUTTERWORTH 0.70710678f
+#define BIQUAD_SHIFT 30 // fractional bits of the fixed point coefficients, all coefficients are within +/-2
+
+/**
+ * @brief Coefficients of a biquad, normalized to a0 = 1
+ *
+ * @details Calculated in floating point after the RBJ audio EQ cookbook, only when a filter is (re)configured.
+ */
+typedef struct biquadCoeffs {
+	f32 b0, b1, b2, a1, a2;
+} BiquadCoeffs;
+
+/**
+ * @brief calculates the coefficients of a biquad
+ *
+ * @param type Response of the filter
+ * @param freq Cutoff or center frequency, below half the sample frequency
+ * @param q Quality factor
+ * @param sampleFreq Sample frequency of the filter
+ */
+BiquadCoeffs biquadCoeffs(BiquadType type, f32 freq, f32 q, u32 sampleFreq);
+
+/// @brief Coefficients of a biquad in 2.30 fixed point, normalized to a0 = 1
+typedef struct biquadCoeffsFix {
+	i32 b0, b1, b2, a1, a2;
+} BiquadCoeffsFix;
+
+/// @brief calculates the coefficients of a biquad, see biquadCoeffs, and converts them to 2.30 fixed point
+BiquadCoeffsFix biquadCoeffsFix(BiquadType type, fix32 freq, fix32 q, u32 sampleFreq);
+
+/**
+ * @brief coefficients of a Butterworth low pass from the compile-time cutoff tables, fast enough to be called every loop
+ *
+ * @details Interpolates a1 and a2 between the table entries (interpolated coefficients stay stable, the stability
+ * triangle is convex) and derives b0 = b2 = b1 / 2 from them for exact unity gain at DC.
+ * @param freq Cutoff frequency, up to (FILTER_LUT_SIZE - 1) * FILTER_LUT_STEP, at FILTER_LUT_SAMPLE_FREQ
+ */
+BiquadCoeffsFix lowpassCoeffsLut(fix32 freq);
+
+/**
+ * @brief one sample through a biquad, direct form I
+ *
+ * @details The five products are summed in 64 bits and shifted once. The M0+ has no 32x32 => 64 bit multiply, so each
+ * product is built from four 16x16 bit multiplications inline (smul32x32) instead of a call to __aeabi_lmul, 20 in total.
+ * Values have to stay within +/-16384 (plenty for deg/s).
+ * @param x input sample
+ * @param c coefficients
+ * @param x1 x2 y1 y2 state of the filter, last inputs and outputs
+ * @return fix32 output sample
+ */
+inline fix32 biquadStep(fix32 x, const BiquadCoeffsFix &c, fix32 &x1, fix32 &x2, fix32 &y1, fix32 &y2) {
+	const i64 acc = smul32x32(c.b0, x.raw) + smul32x32(c.b1, x1.raw) + smul32x32(c.b2, x2.raw) - smul32x32(c.a1, y1.raw) - smul32x32(c.a2, y2.raw);
+	x2 = x1;
+	x1 = x;
+	y2 = y1;
+	y1.setRaw((acc + (1 << (BIQUAD_SHIFT - 1))) >> BIQUAD_SHIFT);
+	return y1;
+}
+
+/**
+ * @brief calculates notch coefficients in fixed point, for notches that follow a frequency every few loops
+ *
+ * @details Same response as BiquadType::NOTCH, but with sinFix/cosFix instead of software float (call startFixTrig()
+ * before). A notch has b2 = b0 and b1 = a1, so 3 coefficients in 2.30 fixed point are enough, see notchStep.
+ * @param freq Center frequency, below half the sample frequency
+ * @param q Quality factor (center frequency / bandwidth)
+ * @param sampleFreq Sample frequency of the filter
+ */
+void notchCoeffsFix(fix32 freq, fix32 q, u32 sampleFreq, i32 &b0, i32 &a1, i32 &a2);
+
+/**
+ * @brief one sample through a notch with coefficients of notchCoeffsFix, direct form I
+ *
+ * @details Three products (smul32x32, 12 16x16 bit multiplications), values have to stay within +/-16384 like for biquadStep.
+ * @param x input sample
+ * @param x1 x2 y1 y2 state of the notch, last inputs and outputs
+ * @return fix32 output sample
+ */
+inline fix32 notchStep(fix32 x, i32 b0, i32 a1, i32 a2, fix32 &x1, fix32 &x2, fix32 &y1, fix32 &y2) {
+	const i64 acc = smul32x32(b0, x.raw + x2.raw) + smul32x32(a1, x1.raw - y1.raw) - smul32x32(a2, y2.raw);
+	x2 = x1;
+	x1 = x;
+	y2 = y1;
+	y1.setRaw((acc + (1 << (BIQUAD_SHIFT - 1))) >> BIQUAD_SHIFT);
+	return y1;
+}
+
+/**
+ * @brief A second order filter (low pass, notch or band pass), fixed point
+ *
+ * @details Direct form I (biquadStep): the states are the last inputs and outputs as fix32 and the coefficients are 2.30
+ * fixed point, so that low cutoff frequencies keep their accuracy.
+ */
+class Biquad {
+public:
+	/**
+	 * @brief Construct a new Biquad object
+	 *
+	 * @param type Response of the filter
+	 * @param freq Cutoff or center frequency
+	 * @param sampleFreq Sample frequency of the filter (rate at which .update() is called)
+	 * @param q Quality factor, Butterworth by default
+	 */
+	Biquad(BiquadType type, fix32 freq, u32 sampleFreq, fix32 q = BIQUAD_Q_BUTTERWORTH);
+	/**
+	 * @brief provide a new value to the filter
+	 *
+	 * @param value The new value/sample to be filtered
+	 * @return fix32 The filtered value
+	 */
+	inline fix32 update(fix32 value) {
+		return biquadStep(value, c, x1, x2, y1, y2);
+	}
+	/**
+	 * @brief Set a new frequency and Q, the state is kept, useful for dynamic filters
+	 *
+	 * @param freq The new cutoff or center frequency
+	 * @param q The new quality factor
+	 */
+	void updateParams(fix32 freq, fix32 q);
+	/**
+	 * @brief Set a new frequency, the state is kept, useful for dynamic filters
+	 *
+	 * @param freq The new cutoff or center frequency
+	 */
+	void updateFreq(fix32 freq) { updateParams(freq, q); }
+	/**
+	 * @brief Set a new cutoff frequency for a Butterworth low pass from the compile-time cutoff tables (lowpassCoeffsLut), fast
+	 * enough to be called every loop
+	 *
+	 * @details Only for a LOWPASS with Butterworth Q at a sample frequency of FILTER_LUT_SAMPLE_FREQ.
+	 * @param freq The new cutoff frequency, up to (FILTER_LUT_SIZE - 1) * FILTER_LUT_STEP
+	 */
+	void updateLowpassLut(fix32 freq);
+	/// @brief Get the current value of the filter
+	inline operator fix32() const { return y1; }
+
+private:
+	BiquadType type;
+	u32 sampleFreq;
+	fix32 q;
+	BiquadCoeffsFix c;
+	fix32 x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+};
+
+/**
+ * @brief A second order filter (low pass, notch or band pass), floating point
+ *
+ * @details Transposed direct form II, for values that are already floats. On the M0+ every operation is a software float
+ * call, so the fixed point Biquad is the faster one in the control loop.
+ */
+class BiquadF {
+public:
+	/**
+	 * @brief Construct a new BiquadF object
+	 *
+	 * @param type Response of the filter
+	 * @param freq Cutoff or center frequency
+	 * @param sampleFreq Sample frequency of the filter (rate at which .update() is called)
+	 * @param q Quality factor, Butterworth by default
+	 */
+	BiquadF(BiquadType type, f32 freq, u32 sampleFreq, f32 q = BIQUAD_Q_BUTTERWORTH);
+	/**
+	 * @brief provide a new value to the filter
+	 *
+	 * @param value The new value/sample to be filtered
+	 * @return f32 The filtered value
+	 */
+	inline f32 update(f32 value) {
+		y = c.b0 * value + s1;
+		s1 = c.b1 * value - c.a1 * y + s2;
+		s2 = c.b2 * value - c.a2 * y;
+		return y;
+	}
+	/**
+	 * @brief Set a new frequency and Q, the state is kept, useful for dynamic filters
+	 *
+	 * @param freq The new cutoff or center frequency
+	 * @param q The new quality factor
+	 */
+	void updateParams(f32 freq, f32 q);
+	/// @brief Get the current value of the filter
+	inline operator f32() const { return y; }
+
+private:
+	BiquadType type;
+	u32 sampleFreq;
+	BiquadCoeffs c;
+	f32 s1 = 0, s2 = 0, y = 0;
+};
+
+
+/**
+ * @brief N first order low pass filters with the same cutoff, e.g. one per axis
+ *
+ * @details The states are one contiguous array and all of them are updated in one loop from RAM, instead of one call per
+ * axis. Same response as PT1.
+ */
+template <u32 N>
+class PT1N {
+public:
+	/**
+	 * @brief Construct a new PT1N object
+	 *
+	 * @param cutoffFreq Cutoff frequency of the filters
+	 * @param sampleFreq Sample frequency of the filters (rate at which .update() is called)
+	 */
+	PT1N(fix32 cutoffFreq, u32 sampleFreq) : alpha(pt1Alpha(cutoffFreq, sampleFreq)), sampleFreq(sampleFreq) {}
+	/**
+	 * @brief provide new values to the filters
+	 *
+	 * @param values N new values/samples, fix32 or anything that converts to fix32
+	 */
+	template <typename T>
+	void __not_in_flash_func(update)(const T *values) {
+		const fix32 a = alpha;
+		for (u32 i = 0; i < N; i++)
+			y[i] = y[i] + a * (fix32(values[i]) - y[i]);
+	}
+	/**
+	 * @brief Set a new cutoff frequency for all filters, useful for dynamic filters
+	 *
+	 * @param cutoffFreq The new cutoff frequency
+	 */
+	void updateCutoffFreq(fix32 cutoffFreq) { alpha = pt1Alpha(cutoffFreq, sampleFreq); }
+	/**
+	 * @brief Set a new cutoff frequency for all filters from the compile-time cutoff tables, fast enough to be called every loop
+	 *
+	 * @details Only for a sample frequency of FILTER_LUT_SAMPLE_FREQ.
+	 * @param cutoffFreq The new cutoff frequency, up to (FILTER_LUT_SIZE - 1) * FILTER_LUT_STEP
+	 */
+	void updateCutoffFreqLut(fix32 cutoffFreq) { alpha = pt1AlphaLut(cutoffFreq); }
+	/// @brief Get the current value of filter i
+	inline fix32 operator[](u32 i) const { return y[i]; }
+
+private:
+	fix32 alpha;
+	u32 sampleFreq;
+	fix32 y[N];
+};
+
+/**
+ * @brief N second order filters with the same coefficients, e.g. one per axis
+ *
+ * @details The states are contiguous arrays and all of them are updated in one loop from RAM, instead of one call per
+ * axis. Same response as Biquad.
+ */
+template <u32 N>
+class BiquadN {
+public:
+	/**
+	 * @brief Construct a new BiquadN object
+	 *
+	 * @param type Response of the filters
+	 * @param freq Cutoff or center frequency
+	 * @param sampleFreq Sample frequency of the filters (rate at which .update() is called)
+	 * @param q Quality factor, Butterworth by default
+	 */
+	BiquadN(BiquadType type, fix32 freq, u32 sampleFreq, fix32 q = BIQUAD_Q_BUTTERWORTH)
+		: type(type), sampleFreq(sampleFreq), c(biquadCoeffsFix(type, freq, q, sampleFreq)) {}
+	/**
+	 * @brief filters N values
+	 *
+	 * @param data N new values/samples, replaced by the filtered values
+	 */
+	void __not_in_flash_func(update)(fix32 *data) {
+		const BiquadCoeffsFix k = c;
+		for (u32 i = 0; i < N; i++)
+			data[i] = biquadStep(data[i], k, x1[i], x2[i], y1[i], y2[i]);
+	}
+	/**
+	 * @brief Set a new frequency and Q for all filters, the states are kept
+	 *
+	 * @param freq The new cutoff or center frequency
+	 * @param q The new quality factor
+	 */
+	void updateParams(fix32 freq, fix32 q) { c = biquadCoeffsFix(type, freq, q, sampleFreq); }
+	/**
+	 * @brief Set a new cutoff frequency for Butterworth low passes from the compile-time cutoff tables, fast enough to be called
+	 * every loop
+	 *
+	 * @details Only for a LOWPASS with Butterworth Q at a sample frequency of FILTER_LUT_SAMPLE_FREQ.
+	 * @param freq The new cutoff frequency, up to (FILTER_LUT_SIZE - 1) * FILTER_LUT_STEP
+	 */
+	void updateLowpassLut(fix32 freq) { c = lowpassCoeffsLut(freq); }
+	/// @brief Get the current value of filter i
+	inline fix32 operator[](u32 i) const { return y1[i]; }
+
+private:
+	BiquadType type;
+	u32 sampleFreq;
+	BiquadCoeffsFix c;
+	fix32 x1[N], x2[N], y1[N], y2[N];
+};
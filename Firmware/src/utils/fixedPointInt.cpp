@@ -1,8 +1,6 @@
 #include "global.h"
 #include "hardware/interp.h"
 
-fix32 sinLut[257];
-fix32 atanLut[257];
 interp_config sinInterpConfig0, sinInterpConfig1;
 const fix32 FIX_PI = PI;
 const fix32 FIX_2PI = 2 * PI;
@@ -10,11 +8,68 @@ const fix32 FIX_PI_2 = PI / 2;
 const fix32 FIX_RAD_TO_DEG = 180 / PI;
 const fix32 FIX_DEG_TO_RAD = PI / 180;
 
-void initFixTrig() {
-	for (int i = 0; i <= 256; i++) {
-		sinLut[i] = sin(i * PI / 256);
-		atanLut[i] = atan((f64)i / 256);
+// ======================== compile-time generated tables ========================
+// double precision series that only the compiler evaluates, so booting does no soft float math
+
+/// @brief arctangent of 0...1, reduced to 0...tan(PI / 8) with atan(x) = PI / 4 + atan((x - 1) / (x + 1)) for the Taylor series
+static constexpr f64 constAtan(f64 x) {
+	f64 offset = 0;
+	if (x > 0.41421356237309503) {
+		offset = PI / 4;
+		x = (x - 1) / (x + 1);
+	}
+	f64 term = x, sum = x;
+	for (int n = 1; n < 40; n++) {
+		term *= -x * x;
+		sum += term / (2 * n + 1);
 	}
+	return sum + offset;
+}
+
+/// @brief square root by Newton iterations, for 0.25...4
+static constexpr f64 constSqrt(f64 x) {
+	f64 root = 1;
+	for (int i = 0; i < 8; i++)
+		root = (root + x / root) / 2;
+	return root;
+}
+
+/// @brief arcsine of 0...0.5 as atan(x / sqrt(1 - x^2))
+static constexpr f64 constAsin(f64 x) {
+	return constAtan(x / constSqrt(1 - x * x));
+}
+
+static constexpr f64 constSqrt1(f64 x) {
+	return constSqrt(1 + x);
+}
+
+static constexpr f64 constInvSqrt1(f64 x) {
+	return 1 / constSqrt(1 + x);
+}
+
+/// @brief 257 rounded entries (and a copy of the last one) of f at 0, step, 2 * step..., scale 65536 for fix32
+static constexpr FixLut makeFixLut(f64 (*f)(f64), f64 step, f64 scale = 65536) {
+	FixLut lut;
+	for (int i = 0; i <= 256; i++)
+		lut.v[i].raw = (i32)(f(i * step) * scale + 0.5);
+	lut.v[257] = lut.v[256]; // read with a blend weight of 0 at the end of the range
+	return lut;
+}
+
+// in RAM: these are read in the PID loop and during the attitude update
+constexpr FixLut sinLut __not_in_flash("fixTrig") = makeFixLut(constSin, PI / 256);
+constexpr FixLut atanLut __not_in_flash("fixTrig") = makeFixLut(constAtan, 1. / 256);
+constexpr FixLut asinLut __not_in_flash("fixTrig") = makeFixLut(constAsin, 1. / 512);
+// sqrt(x) and 1 / sqrt(x) for 1...2, raw values in 2.30 instead of fix32
+constexpr FixLut sqrtLut __not_in_flash("fixTrig") = makeFixLut(constSqrt1, 1. / 256, 1 << 30);
+constexpr FixLut invSqrtLut __not_in_flash("fixTrig") = makeFixLut(constInvSqrt1, 1. / 256, 1 << 30);
+static_assert(sinLut[128].raw == 65536 && sinLut[256].raw == 0, "sin(PI / 2) = 1, sin(PI) = 0");
+static_assert(atanLut[256].raw == 51472, "atan(1) = PI / 4");
+static_assert(asinLut[256].raw == 34315, "asin(0.5) = PI / 6");
+static_assert(sqrtLut[0].raw == 1 << 30 && sqrtLut[256].raw == 1518500250, "sqrt(1) = 1, sqrt(2) = 1.41421356");
+static_assert(invSqrtLut[0].raw == 1 << 30 && invSqrtLut[256].raw == 759250125, "1 / sqrt(2) = 0.70710678");
+
+void initFixTrig() {
 	sinInterpConfig0 = interp_default_config();
 	sinInterpConfig1 = interp_default_config();
 	interp_config_set_blend(&sinInterpConfig0, 1);
@@ -70,6 +125,112 @@ fix32 atanFix(fix32 x) {
 	interp0->base[1] = atanLut[high + 1].raw;
 	return fix32().setRaw((i32)interp0->peek[1] * sign + offset);
 }
+
+#define SQRT1_2_Q32 3037000500UL // 1 / sqrt(2) in 0.32
+
+/**
+ * @brief blends between two entries of a table for 1...2, picked by the bits below the leading one of n (bit 31)
+ * @details The interpolator only takes 8 bits of the position within the entry. The 15 bits below add a linear correction,
+ * otherwise they would limit the relative error of a square root to 8e-6.
+ */
+static inline u32 lutBlend12(const FixLut &lut, const u32 n) {
+	const u32 high = (n >> 23) & 0xFF;
+	const i32 base0 = lut[high].raw, base1 = lut[high + 1].raw;
+	interp0->accum[1] = (n >> 15) & 0xFF;
+	interp0->base[0] = base0;
+	interp0->base[1] = base1;
+	return interp0->peek[1] + ((((base1 - base0) >> 5) * (i32)(n & 0x7FFF)) >> 18); // difference below 2^21
+}
+
+u32 sqrtSplit(const u32 x, i32 *halfExp) {
+	const i32 clz = __builtin_clz(x);
+	u32 s = lutBlend12(sqrtLut, x << clz); // sqrt(x * 2^(clz - 31))
+	const i32 e = 31 - clz;
+	if (e & 1) s = umul32x32(s, SQRT1_2_Q32) >> 31; // * sqrt(2)
+	*halfExp = e >> 1;
+	return s;
+}
+
+u32 invSqrtSplit(const u32 x, i32 *halfExp) {
+	const i32 clz = __builtin_clz(x);
+	u32 s = lutBlend12(invSqrtLut, x << clz);
+	const i32 e = 31 - clz;
+	if (e & 1) s = umul32x32(s, SQRT1_2_Q32) >> 32; // / sqrt(2)
+	*halfExp = e >> 1;
+	return s;
+}
+
+/**
+ * @brief calculates the square root of a fixed point number, faster than sqrtf
+ * @details interpolated table of sqrt(1...2) after shifting the leading one to bit 31. The relative error is below
+ * 5e-7, plus the rounding to fix32. Important: Call startFixTrig() once before every calculation batch
+ * @param x >= 0, 0 for negative inputs
+ */
+fix32 sqrtFix(const fix32 x) {
+	if (x.raw <= 0) return 0;
+	i32 halfExp;
+	const u32 s = sqrtSplit(x.raw, &halfExp); // sqrt(x.raw / 2^16) = s / 2^30 * 2^halfExp / 2^8
+	const i32 shift = 22 - halfExp;
+	return fix32().setRaw((s + (1UL << (shift - 1))) >> shift);
+}
+
+/**
+ * @brief calculates 1 / sqrt(x) of a fixed point number, faster than 1 / sqrtf
+ * @details interpolated table of 1 / sqrt(1...2) after shifting the leading one to bit 31. The relative error is below
+ * 2e-6, plus the rounding to fix32. Important: Call startFixTrig() once before every calculation batch
+ * @param x > 0, the largest fix32 value for 0 and negative inputs
+ */
+fix32 invSqrtFix(const fix32 x) {
+	if (x.raw <= 0) return fix32().setRaw(INT32_MAX);
+	i32 halfExp;
+	const u32 s = invSqrtSplit(x.raw, &halfExp); // 1 / sqrt(x.raw / 2^16) = s / 2^30 / 2^halfExp * 2^8
+	const i32 shift = 6 + halfExp;
+	return fix32().setRaw((s + (1UL << (shift - 1))) >> shift);
+}
+
+/**
+ * @brief calculates the arcsine of a fixed point number, faster than asinf
+ * @details The table covers 0...0.5, above that asin(x) = PI/2 - 2 * asin(sqrt((1 - x) / 2)) avoids the infinite slope at 1,
+ * with the square root from the table of sqrtFix.
+ * Accurate to about +-0.00004 for the given fix32 input. Important: Call initFixTrig() once at the start. Also call startFixTrig() once before every calculation batch to prepare the interpolator for blend mode
+ *
+ * @param x -1...1, clamped
+ * @return fix32 radians
+ */
+fix32 asinFix(fix32 x) {
+	const i32 sign = x.sign();
+	i32 xRaw = x.raw * sign;
+	if (xRaw > 0x10000) xRaw = 0x10000;
+	xRaw <<= 1; // 15.17, 256 entries for 0...0.5
+	const bool upper = xRaw > 0x10000;
+	if (upper && xRaw < 0x20000) {
+		// sqrt((1 - x) / 2) in 15.17
+		i32 halfExp;
+		const u32 s = sqrtSplit((u32)(0x20000 - xRaw) << 16, &halfExp);
+		const i32 shift = 30 - halfExp;
+		xRaw = (s + (1UL << (shift - 1))) >> shift;
+	} else if (upper)
+		xRaw = 0;
+	u32 high = xRaw >> 8;
+	interp0->accum[1] = xRaw & 0xFF;
+	interp0->base[0] = asinLut[high].raw;
+	interp0->base[1] = asinLut[high + 1].raw;
+	i32 res = interp0->peek[1];
+	if (upper) res = FIX_PI_2.raw - 2 * res;
+	return fix32().setRaw(res * sign);
+}
+
+/**
+ * @brief calculates the arccosine of a fixed point number as PI/2 - asinFix(x), faster than acosf
+ * @details same error as asinFix, about +-0.00004. Important: Call startFixTrig() once before every calculation batch
+ *
+ * @param x -1...1, clamped
+ * @return fix32 radians, 0...PI
+ */
+fix32 acosFix(const fix32 x) {
+	return FIX_PI_2 - asinFix(x);
+}
+
 fix32 atan2Fix(const fix32 y, const fix32 x) {
 	if (x != 0)
 		return atanFix(y / x) + FIX_PI * (x.raw < 0) * y.sign();
@@ -12,6 +12,7 @@ extern const fix32 FIX_PI_2;
 extern const fix32 FIX_RAD_TO_DEG;
 extern const fix32 FIX_DEG_TO_RAD;
 
+/// @brief sets up the interpolator configurations of the fix32 trig functions, the tables need no initialization
 void initFixTrig();
 /**
  * @brief prepares the interpolator for blend mode
@@ -25,8 +26,44 @@ inline void startFixTrig() {
 fix32 sinFix(const fix32 x);
 fix32 cosFix(const fix32 x);
 fix32 atanFix(const fix32 x);
+fix32 asinFix(fix32 x);
+fix32 acosFix(const fix32 x);
+fix32 sqrtFix(const fix32 x);
+fix32 invSqrtFix(const fix32 x);
+/**
+ * @brief table based square root of an unsigned integer, the basis of sqrtFix
+ * @param x > 0
+ * @param halfExp set to the power of two of the result: sqrt(x) = result / 2^30 * 2^halfExp
+ * @return 1...2 in 2.30, relative error below 5e-7
+ */
+u32 sqrtSplit(const u32 x, i32 *halfExp);
+/**
+ * @brief table based inverse square root of an unsigned integer, the basis of invSqrtFix
+ * @param x > 0
+ * @param halfExp set to the power of two of the result: 1 / sqrt(x) = result / 2^30 / 2^halfExp
+ * @return 0.707...1 in 2.30, relative error below 2e-6
+ */
+u32 invSqrtSplit(const u32 x, i32 *halfExp);
 fix32 atan2Fix(const fix32 y, const fix32 x);
 
+/**
+ * @brief 32x32 => 64 bit unsigned multiplication
+ * @details The M0+ has no long multiply (umull/smull), so GCC calls __aeabi_lmul with 64 bit operands for a widening
+ * multiply. Four 16x16 products with the single cycle 32 bit multiply are faster and stay inline.
+ */
+inline constexpr u64 umul32x32(const u32 a, const u32 b) {
+	const u32 al = a & 0xFFFF, ah = a >> 16, bl = b & 0xFFFF, bh = b >> 16;
+	const u32 ll = al * bl;
+	const u32 mid = ah * bl + (ll >> 16); // can't overflow: (2^16 - 1)^2 + 2^16 - 1 < 2^32
+	const u32 mid2 = (mid & 0xFFFF) + al * bh;
+	return ((u64)(ah * bh + (mid >> 16) + (mid2 >> 16)) << 32) | (mid2 << 16) | (ll & 0xFFFF);
+}
+/// @brief 32x32 => 64 bit signed multiplication, the unsigned product with the upper word corrected for negative inputs
+inline constexpr i64 smul32x32(const i32 a, const i32 b) {
+	const u32 correction = (a < 0 ? (u32)b : 0) + (b < 0 ? (u32)a : 0);
+	return (i64)(umul32x32(a, b) - ((u64)correction << 32));
+}
+
 class fix64 {
 	// 32.32 fixed point
 public:
@@ -61,6 +98,7 @@ public:
 		return (u32)(this->raw >> 32);
 	};
 	inline constexpr fix32 getfix32() const;
+	inline constexpr fix32 getfix32Sat() const;
 
 	// ======================== fix64 arithmetics ========================
 	inline constexpr fix64 operator+(const fix64 other) const {
@@ -70,15 +108,13 @@ public:
 		return fix64().setRaw(this->raw - other.raw);
 	};
 	inline constexpr fix64 operator*(const fix64 other) const {
-		i32 sign0 = this->sign();
-		i32 sign1 = other.sign();
-		i32 sign = sign0 * sign1;
-		u64 pos0 = this->raw * sign0;
-		u64 pos1 = other.raw * sign1;
-		u64 big = (pos0 >> 32) * (pos1 >> 32);
-		u64 small = (pos0 & 0xFFFFFFFF) * (pos1 & 0xFFFFFFFF);
-		u64 med = (pos0 >> 32) * (pos1 & 0xFFFFFFFF) + (pos0 & 0xFFFFFFFF) * (pos1 >> 32);
-		return fix64().setRaw((i64)((big << 32) + med + (small >> 32)) * sign);
+		// signed 64x64 => upper 64 bits of the lower 96, from three widening products and one 32 bit product
+		const u32 al = (u32)this->raw, bl = (u32)other.raw;
+		const i32 ah = (i32)(this->raw >> 32), bh = (i32)(other.raw >> 32);
+		u64 res = umul32x32(al, bl) >> 32;
+		res += umul32x32(ah, bl) + umul32x32(al, bh);
+		res += (u64)((u32)ah * (u32)bh - (ah < 0 ? bl : 0) - (bh < 0 ? al : 0)) << 32;
+		return fix64().setRaw((i64)res);
 	};
 	inline constexpr bool operator==(const fix64 other) const {
 		return this->raw == other.raw;
@@ -204,6 +240,25 @@ public:
 	inline constexpr fix32 operator%(const fix32 other) const {
 		return fix32().setRaw(this->raw % other.raw);
 	};
+	/// @brief addition that saturates at the fix32 range instead of wrapping
+	inline constexpr fix32 addSat(const fix32 other) const {
+		i32 res = 0;
+		if (__builtin_add_overflow(this->raw, other.raw, &res))
+			res = this->raw < 0 ? INT32_MIN : INT32_MAX;
+		return fix32().setRaw(res);
+	};
+	/// @brief subtraction that saturates at the fix32 range instead of wrapping
+	inline constexpr fix32 subSat(const fix32 other) const {
+		i32 res = 0;
+		if (__builtin_sub_overflow(this->raw, other.raw, &res))
+			res = this->raw < 0 ? INT32_MIN : INT32_MAX;
+		return fix32().setRaw(res);
+	};
+	/// @brief multiplication that saturates at the fix32 range instead of wrapping
+	inline constexpr fix32 mulSat(const fix32 other) const {
+		const i64 res = smul32x32(this->raw, other.raw) >> 16;
+		return fix32().setRaw(res > INT32_MAX ? INT32_MAX : res < INT32_MIN ? INT32_MIN : (i32)res);
+	};
 	inline constexpr fix32 operator+=(const fix32 other) {
 		this->raw += other.raw;
 		return *this;
@@ -470,12 +525,45 @@ public:
 	};
 };
 
+/// @brief sine of 0...PI by its Taylor series, for tables that the compiler generates
+inline constexpr f64 constSin(f64 x) {
+	if (x > PI / 2) x = PI - x;
+	f64 term = x, sum = x;
+	for (int n = 1; n < 12; n++) {
+		term *= -x * x / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+/// @brief cosine of 0...PI, see constSin
+inline constexpr f64 constCos(f64 x) {
+	return x <= PI / 2 ? constSin(PI / 2 - x) : -constSin(x - PI / 2);
+}
+
+/**
+ * @brief 258 entries of a fix32 interpolation table, the last one is a copy for blending at the end of the range
+ * @details A struct instead of an array so that constexpr functions can return it
+ */
+typedef struct fixLut {
+	fix32 v[258];
+	inline constexpr fix32 operator[](const u32 i) const {
+		return v[i];
+	};
+} FixLut;
+extern const FixLut sinLut, atanLut, asinLut, sqrtLut, invSqrtLut; // tables of the fix32 trig and root functions, generated at compile time
+
 inline constexpr fix64::fix64(const fix32 v) {
 	this->raw = (i64)v.raw << 16;
 };
 inline constexpr fix32 fix64::getfix32() const {
 	return fix32().setRaw((i32)(this->raw >> 16));
 }
+/// @brief conversion to fix32 that saturates at the fix32 range instead of wrapping
+inline constexpr fix32 fix64::getfix32Sat() const {
+	const i64 r = this->raw >> 16;
+	return fix32().setRaw(r > INT32_MAX ? INT32_MAX : r < INT32_MIN ? INT32_MIN : (i32)r);
+}
 inline constexpr fix64 fix64::operator+(const fix32 other) const {
 	return fix64().setRaw(this->raw + (((i64)other.raw) << 16));
 }
@@ -483,13 +571,10 @@ inline constexpr fix64 fix64::operator-(const fix32 other) const {
 	return fix64().setRaw(this->raw - (((i64)other.raw) << 16));
 }
 inline constexpr fix64 fix64::operator*(const fix32 other) const {
-	i32 sign = this->sign();
-	i64 pos = this->raw * sign;
-	i64 lo = (pos & 0xFFFFFFFFLL) * other.raw;
-	i64 hi = (pos >> 32) * other.raw;
-	hi <<= 16;
-	lo >>= 16;
-	return fix64().setRaw((hi + lo) * sign);
+	const u32 lo = (u32)this->raw;
+	const i64 loProduct = (i64)(umul32x32(lo, other.raw) - (other.raw < 0 ? (u64)lo << 32 : 0));
+	const i64 hiProduct = smul32x32((i32)(this->raw >> 32), other.raw);
+	return fix64().setRaw((i64)((u64)hiProduct << 16) + (loProduct >> 16));
 }
 inline constexpr fix64 fix64::operator/(const fix32 other) const {
 	i32 sign0 = this->sign();
@@ -0,0 +1,42 @@
+#include "global.h"
+
+void QuaternionFix_setIdentity(QuaternionFix *q) {
+	q->w = QUAT_FIX_ONE;
+	q->v[0] = 0;
+	q->v[1] = 0;
+	q->v[2] = 0;
+}
+
+void __not_in_flash_func(QuaternionFix_normalize)(QuaternionFix *q) {
+	const i64 n = ((i64)q->w * q->w + (i64)q->v[0] * q->v[0] + (i64)q->v[1] * q->v[1] + (i64)q->v[2] * q->v[2]) >> QUAT_FIX_SHIFT;
+	const i32 y = ((3LL << QUAT_FIX_SHIFT) - n) >> 1;
+	q->w = quatFixMul(q->w, y);
+	q->v[0] = quatFixMul(q->v[0], y);
+	q->v[1] = quatFixMul(q->v[1], y);
+	q->v[2] = quatFixMul(q->v[2], y);
+}
+
+i32 __not_in_flash_func(quatFixInvSqrt)(u32 x, i32 *halfShift) {
+	// start value from the table of invSqrtFix: 1 / sqrt(x) = y / 2^30 / 2^e
+	i32 e;
+	i32 y = invSqrtSplit(x, &e);
+	*halfShift = 15 - e;
+	x <<= 2 * (15 - e); // 1...4 in 2.30 now
+	const u64 y2 = ((i64)y * y) >> QUAT_FIX_SHIFT;
+	const i64 xy2 = (x * y2) >> QUAT_FIX_SHIFT;
+	return ((i64)y * ((3LL << QUAT_FIX_SHIFT) - xy2)) >> (QUAT_FIX_SHIFT + 1);
+}
+
+void QuaternionFix_fromFloat(const Quaternion *q, QuaternionFix *output) {
+	output->w = q->w * QUAT_FIX_ONE;
+	output->v[0] = q->v[0] * QUAT_FIX_ONE;
+	output->v[1] = q->v[1] * QUAT_FIX_ONE;
+	output->v[2] = q->v[2] * QUAT_FIX_ONE;
+}
+
+void QuaternionFix_toFloat(const QuaternionFix *q, Quaternion *output) {
+	output->w = (f32)q->w / QUAT_FIX_ONE;
+	output->v[0] = (f32)q->v[0] / QUAT_FIX_ONE;
+	output->v[1] = (f32)q->v[1] / QUAT_FIX_ONE;
+	output->v[2] = (f32)q->v[2] / QUAT_FIX_ONE;
+}
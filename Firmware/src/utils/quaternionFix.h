@@ -0,0 +1,45 @@
+#pragma once
+#include "quaternion.h"
+#include "typedefs.h"
+
+#define QUAT_FIX_SHIFT 30 // fractional bits of QuaternionFix, same 2.30 format as the biquad coefficients
+#define QUAT_FIX_ONE (1L << QUAT_FIX_SHIFT)
+
+/**
+ * @brief quaternion in 2.30 fixed point
+ * @details fix32 is too coarse for the attitude: one gyro LSB integrates to about 1.7e-7 rad per loop, fix32 resolves
+ * 1.5e-5. 2.30 resolves 9.3e-10 and holds every component of a unit quaternion, as well as sums of two of them.
+ */
+typedef struct quaternionFix {
+	i32 v[3], w;
+} QuaternionFix;
+
+/// @brief product of two 2.30 numbers
+inline i32 quatFixMul(const i32 a, const i32 b) {
+	return ((i64)a * b) >> QUAT_FIX_SHIFT;
+}
+
+void QuaternionFix_setIdentity(QuaternionFix *q);
+
+/**
+ * @brief normalizes a quaternion that is already close to unit length
+ * @details One Newton step of 1/sqrt(n) = y * (3 - n * y^2) / 2, starting at y = 1. The remaining error is about
+ * 3/8 of the squared input error, e.g. 4e-14 for the 3e-7 after an integration or correction step.
+ * @param q quaternion with a squared length of 0...3, converges quickly only near 1
+ */
+void QuaternionFix_normalize(QuaternionFix *q);
+
+/**
+ * @brief 1 / sqrt(x) of any positive number, with a Newton iteration
+ * @details The start value comes from the table of invSqrtFix (within 2e-6), one Newton iteration
+ * y = y * (3 - x * y^2) / 2 brings that below the 2.30 resolution. Call startFixTrig() before.
+ * @param x 2.30 input (1 / sqrt(x) = y * 2^halfShift), or an integer (1 / sqrt(x) = y * 2^(halfShift - 15)), must not be 0
+ * @param halfShift set to half the number of bits that x was shifted by, 0...15
+ * @return y: 2.30 result of the input shifted by 2 * halfShift bits into 1...4, 0.5...1
+ */
+i32 quatFixInvSqrt(u32 x, i32 *halfShift);
+
+/// @brief converts a float quaternion to 2.30
+void QuaternionFix_fromFloat(const Quaternion *q, QuaternionFix *output);
+/// @brief converts a 2.30 quaternion to float
+void QuaternionFix_toFloat(const QuaternionFix *q, Quaternion *output);